@@ -2,11 +2,17 @@
 /* Written by Ian Seyler of Return Infinity */
 
 /* Global includes */
+#define _GNU_SOURCE		// copy_file_range, ftruncate, pread/pwrite
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
 #include <ctype.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
 
 /* Global defines */
 struct BMFSEntry
@@ -21,6 +27,17 @@ struct BMFSEntry
 /* Global constants */
 // Min disk size is 6MiB (three blocks of 2MiB each.)
 const unsigned long long minimumDiskSize = (6 * 1024 * 1024);
+// Copies go through one BMFS block at a time, page aligned
+const size_t copyBufferSize = (2 * 1024 * 1024);
+const size_t copyBufferAlignment = 4096;
+// Updates compare the image against the new contents in chunks of this size
+const size_t updateChunkSize = (64 * 1024);
+// 64-bit FNV-1a, for the contents hash kept in the directory entry
+const unsigned long long fnvOffsetBasis = 0xCBF29CE484222325ULL;
+const unsigned long long fnvPrime = 0x100000001B3ULL;
+// Boot loader and kernel live between the directory and the first file block
+const unsigned long long bootAreaStart = 8192;
+const unsigned long long bootAreaEnd = 2097152;
 
 /* Global variables */
 FILE *file, *disk;
@@ -35,6 +52,7 @@ char s_create[] = "create";
 char s_read[] = "read";
 char s_write[] = "write";
 char s_delete[] = "delete";
+char s_update[] = "update";
 struct BMFSEntry entry;
 void *pentry = &entry;
 char *BlockMap;
@@ -48,9 +66,17 @@ void list();
 void format();
 int initialize(char *diskname, char *size, char *mbr, char *boot, char *kernel);
 void create(char *filename, unsigned long long maxsize);
-void read(char *filename);
-void write(char *filename);
+void readfile(char *filename);
+void writefile(char *filename);
 void delete(char *filename);
+int update(char *mbr, char *boot, char *kernel);
+static unsigned long long copydata(int in, unsigned long long inOffset, int out, unsigned long long outOffset, unsigned long long length);
+static int fillzeros(int out, unsigned long long length);
+static unsigned long long updatedata(int in, unsigned long long inOffset, int out, unsigned long long outOffset, unsigned long long length, unsigned long long *written);
+static unsigned long long hashdata(const void *data, size_t length, unsigned long long hash);
+static int hashfile(int in, unsigned long long length, unsigned long long *hash);
+static double now();
+static void report(const char *what, unsigned long long bytes, double seconds);
 
 /* Program code */
 int main(int argc, char *argv[])
@@ -62,7 +88,7 @@ int main(int argc, char *argv[])
 		printf("Written by Ian Seyler @ Return Infinity (ian.seyler@returninfinity.com)\n\n");
 		printf("Usage: %s disk function file\n", argv[0]);
 		printf("Disk: the name of the disk file\n");
-		printf("Function: list, read, write, create, delete, format, initialize\n");
+		printf("Function: list, read, write, create, delete, format, initialize, update\n");
 		printf("File: (if applicable)\n");
 		exit(0);
 	}
@@ -177,16 +203,25 @@ int main(int argc, char *argv[])
 	}
 	else if (strcasecmp(s_read, command) == 0)
 	{
-		read(filename);
+		readfile(filename);
 	}
 	else if (strcasecmp(s_write, command) == 0)
 	{
-		write(filename);
+		writefile(filename);
 	}
 	else if (strcasecmp(s_delete, command) == 0)
 	{
 		delete(filename);
 	}
+	else if (strcasecmp(s_update, command) == 0)
+	{
+		char *mbr = (argc > 3 ? argv[3] : NULL);
+		char *boot = (argc > 4 ? argv[4] : NULL);
+		char *kernel = (argc > 5 ? argv[5] : NULL);
+		int ret = update(mbr, boot, kernel);
+		fclose(disk);
+		exit(ret);
+	}
 	else
 	{
 		printf("Unknown command\n");
@@ -273,15 +308,14 @@ int initialize(char *diskname, char *size, char *mbr, char *boot, char *kernel)
 	unsigned long long diskSize = 0;
 	unsigned long long writeSize = 0;
 	const char *bootFileType = NULL;
-	size_t bufferSize = 50 * 1024;
-	char * buffer = NULL;
+	char buffer[512];
 	FILE *mbrFile = NULL;
 	FILE *bootFile = NULL;
 	FILE *kernelFile = NULL;
 	int diskSizeFactor = 0;
-	size_t chunkSize = 0;
 	int ret = 0;
 	size_t i;
+	double start = now();
 
 	// Determine how the second file will be described in output messages.
 	// If a kernel file is specified too, then assume the second file is the
@@ -419,17 +453,6 @@ int initialize(char *diskname, char *size, char *mbr, char *boot, char *kernel)
 		}
 	}
 
-	// Allocate buffer to use for filling the disk image with zeros.
-	if (ret == 0)
-	{
-		buffer = (char *) malloc(bufferSize);
-		if (buffer == NULL)
-		{
-			printf("Error: Failed to allocate buffer\n");
-			ret = 1;
-		}
-	}
-
 	// Open the disk image file for writing.  This will truncate the disk file
 	// if it already exists, so we should do this only after we're ready to
 	// actually write to the file.
@@ -443,34 +466,16 @@ int initialize(char *diskname, char *size, char *mbr, char *boot, char *kernel)
 		}
 	}
 
-	// Fill the disk image with zeros.
+	// Size the disk image. Extending the file leaves it sparse: the zeros are
+	// not written and take no space. Devices (or filesystems without sparse
+	// files) get the zeros written in large chunks instead.
 	if (ret == 0)
 	{
-		double percent;
-		memset(buffer, 0, bufferSize);
-		writeSize = 0;
-		while (writeSize < diskSize)
-		{
-			percent = writeSize;
-			percent /= diskSize;
-			percent *= 100;
-			printf("Formatting disk: %llu of %llu bytes (%.0f%%)...\r", writeSize, diskSize, percent);
-			chunkSize = bufferSize;
-			if (chunkSize > diskSize - writeSize)
-			{
-				chunkSize = diskSize - writeSize;
-			}
-			if (fwrite(buffer, chunkSize, 1, disk) != 1)
-			{
-				printf("Error: Failed to write disk '%s'\n", diskname);
-				ret = 1;
-				break;
-			}
-			writeSize += chunkSize;
-		}
-		if (ret == 0)
+		printf("Formatting disk: %llu bytes\n", diskSize);
+		if (ftruncate(fileno(disk), diskSize) != 0 && fillzeros(fileno(disk), diskSize) != 0)
 		{
-			printf("Formatting disk: %llu of %llu bytes (100%%)%9s\n", writeSize, diskSize, "");
+			printf("Error: Failed to write disk '%s'\n", diskname);
+			ret = 1;
 		}
 	}
 
@@ -502,59 +507,32 @@ int initialize(char *diskname, char *size, char *mbr, char *boot, char *kernel)
 	}
 
 	// Write the boot loader if it was specified by the caller.
+	writeSize = 8192;
+	fflush(disk);
 	if (ret == 0 && bootFile !=NULL)
 	{
+		struct stat info;
 		printf("Writing %s file.\n", bootFileType);
-		fseek(disk, 8192, SEEK_SET);
-		for (;;)
+		if (fstat(fileno(bootFile), &info) != 0 || copydata(fileno(bootFile), 0, fileno(disk), writeSize, info.st_size) != (unsigned long long)info.st_size)
 		{
-			chunkSize = fread( buffer, 1, bufferSize, bootFile);
-			if (chunkSize > 0)
-			{
-				if (fwrite(buffer, chunkSize, 1, disk) != 1)
-				{
-					printf("Error: Failed to write disk '%s'\n", diskname);
-					ret = 1;
-				}
-			}
-			else
-			{
-				if (ferror(disk))
-				{
-					printf("Error: Failed to read file '%s'\n", boot);
-					ret = 1;
-				}
-				break;
-			}
+			printf("Error: Failed to copy file '%s' to disk '%s'\n", boot, diskname);
+			ret = 1;
 		}
+		writeSize += info.st_size;
 	}
 
 	// Write the kernel if it was specified by the caller. The kernel must
-	// immediately follow the boot loader on disk (i.e. no seek needed.)
+	// immediately follow the boot loader on disk.
 	if (ret == 0 && kernelFile !=NULL)
 	{
+		struct stat info;
 		printf("Writing kernel.\n");
-		for (;;)
+		if (fstat(fileno(kernelFile), &info) != 0 || copydata(fileno(kernelFile), 0, fileno(disk), writeSize, info.st_size) != (unsigned long long)info.st_size)
 		{
-			chunkSize = fread( buffer, 1, bufferSize, kernelFile);
-			if (chunkSize > 0)
-			{
-				if (fwrite(buffer, chunkSize, 1, disk) != 1)
-				{
-					printf("Error: Failed to write disk '%s'\n", diskname);
-					ret = 1;
-				}
-			}
-			else
-			{
-				if (ferror(disk))
-				{
-					printf("Error: Failed to read file '%s'\n", kernel);
-					ret = 1;
-				}
-				break;
-			}
+			printf("Error: Failed to copy file '%s' to disk '%s'\n", kernel, diskname);
+			ret = 1;
 		}
+		writeSize += info.st_size;
 	}
 
 	// Close any files that were opened.
@@ -576,15 +554,10 @@ int initialize(char *diskname, char *size, char *mbr, char *boot, char *kernel)
 		disk = NULL;
 	}
 
-	// Free the buffer if it was allocated.
-	if (buffer != NULL)
-	{
-		free(buffer);
-	}
-
 	if (ret == 0)
 	{
 		printf("Disk initialization complete.\n");
+		report("Boot files written", writeSize - 8192, now() - start);
 	}
 
 	return ret;
@@ -717,11 +690,11 @@ void create(char *filename, unsigned long long maxsize)
 }
 
 
-void read(char *filename)
+void readfile(char *filename)
 {
 	struct BMFSEntry tempentry;
 	FILE *tfile;
-	int tint, slot;
+	int slot;
 
 	if (0 == findfile(filename, &tempentry, &slot))
 	{
@@ -736,24 +709,27 @@ void read(char *filename)
 		}
 		else
 		{
-			fseek(disk, tempentry.StartingBlock*2097152, SEEK_SET); // Skip to the starting block in the disk
-			for (tint=0; tint<tempentry.FileSize; tint++)
+			double start = now();
+			if (copydata(fileno(disk), tempentry.StartingBlock*2097152, fileno(tfile), 0, tempentry.FileSize) != tempentry.FileSize)
 			{
-				putc(getc(disk), tfile);			// This is really terrible.
-				// TODO: Rework with fread and fwrite (ideally with a 2MiB buffer)
+				printf("Error: Failed to read file from disk '%s'\n", diskname);
+			}
+			else
+			{
+				printf("Complete\n");
+				report("Read", tempentry.FileSize, now() - start);
 			}
 			fclose(tfile);
-			printf("Complete\n");
 		}
 	}
 }
 
 
-void write(char *filename)
+void writefile(char *filename)
 {
 	struct BMFSEntry tempentry;
 	FILE *tfile;
-	int tint, slot;
+	int slot;
 	unsigned long long tempfilesize;
 
 	if (0 == findfile(filename, &tempentry, &slot))
@@ -779,17 +755,31 @@ void write(char *filename)
 			}
 			else
 			{
-				fseek(disk, tempentry.StartingBlock*2097152, SEEK_SET); // Skip to the starting block in the disk
-				for (tint=0; tint<tempfilesize; tint++)
+				double start = now();
+				unsigned long long hash, written;
+				// The unused field of the entry keeps a hash of the contents
+				if (hashfile(fileno(tfile), tempfilesize, &hash) != 0)
 				{
-					putc(getc(tfile), disk);			// This is really terrible.
-					// TODO: Rework with fread and fwrite (ideally with a 2MiB buffer)
+					printf("Error: Could not read local file '%s'\n", filename);
+				}
+				else if (tempentry.FileSize == tempfilesize && tempentry.Unused == hash)
+				{
+					printf("Unchanged\n");
+				}
+				else if (updatedata(fileno(tfile), 0, fileno(disk), tempentry.StartingBlock*2097152, tempfilesize, &written) != tempfilesize)
+				{
+					printf("Error: Failed to write file to disk '%s'\n", diskname);
+				}
+				else
+				{
+					// Update directory
+					memcpy(Directory+(slot*64)+48, &tempfilesize, 8);
+					memcpy(Directory+(slot*64)+56, &hash, 8);
+					fseek(disk, 4096, SEEK_SET);				// Seek 4KiB in for directory
+					fwrite(Directory, 4096, 1, disk);			// Write new directory to disk
+					printf("Complete\n");
+					report("Written", written, now() - start);
 				}
-				// Update directory
-				memcpy(Directory+(slot*64)+48, &tempfilesize, 8);
-				fseek(disk, 4096, SEEK_SET);				// Seek 4KiB in for directory
-				fwrite(Directory, 4096, 1, disk);			// Write new directory to disk
-				printf("Complete\n");
 			}
 			fclose(tfile);
 		}
@@ -819,4 +809,227 @@ void delete(char *filename)
 }
 
 
+// Bring the boot area of an existing disk up to date: only the chunks that
+// changed are written, so rebuilding the image after a kernel change does
+// not rewrite it (nor the files) from scratch.
+int update(char *mbr, char *boot, char *kernel)
+{
+	char *names[3] = { mbr, boot, kernel };
+	unsigned long long offset[3] = { 0, bootAreaStart, 0 };
+	unsigned long long written = 0;
+	double start = now();
+	int tint;
+
+	fflush(disk);
+	for (tint = 0; tint < 3; tint++)
+	{
+		struct stat info;
+		unsigned long long chunk;
+		int in;
+
+		if (tint == 2)
+			offset[2] = offset[1];			// The kernel immediately follows the boot loader
+		if (names[tint] == NULL)
+			continue;
+
+		if ((in = open(names[tint], O_RDONLY)) < 0 || fstat(in, &info) != 0)
+		{
+			printf("Error: Unable to open file '%s'\n", names[tint]);
+			return 1;
+		}
+		if (tint == 0 && info.st_size > 512)
+			info.st_size = 512;
+		if (tint > 0 && offset[tint] + info.st_size > bootAreaEnd)
+		{
+			printf("Error: '%s' does not fit before the first file block\n", names[tint]);
+			close(in);
+			return 1;
+		}
+
+		if (updatedata(in, 0, fileno(disk), offset[tint], info.st_size, &chunk) != (unsigned long long)info.st_size)
+		{
+			printf("Error: Failed to update disk '%s' with '%s'\n", diskname, names[tint]);
+			close(in);
+			return 1;
+		}
+		close(in);
+
+		printf("%s: %llu of %llu bytes changed\n", names[tint], chunk, (unsigned long long)info.st_size);
+		if (tint == 1)
+			offset[1] += info.st_size;
+		written += chunk;
+	}
+
+	printf("Disk update complete.\n");
+	report("Boot files written", written, now() - start);
+	return 0;
+}
+
+
+// Copy length bytes between two files at the given offsets. On Linux the
+// kernel moves the data itself with copy_file_range (sharing the blocks on
+// filesystems that support it); anywhere else, or if that fails, the rest
+// goes through a large aligned buffer. Returns the number of bytes copied.
+static unsigned long long copydata(int in, unsigned long long inOffset, int out, unsigned long long outOffset, unsigned long long length)
+{
+	unsigned long long done = 0;
+	void *buffer = NULL;
+
+#ifdef __linux__
+	while (done < length)
+	{
+		loff_t inPos = inOffset + done;
+		loff_t outPos = outOffset + done;
+		ssize_t copied = copy_file_range(in, &inPos, out, &outPos, length - done, 0);
+		if (copied <= 0)
+			break;					// Unsupported here (or end of file)
+		done += copied;
+	}
+#endif
+
+	if (done < length && posix_memalign(&buffer, copyBufferAlignment, copyBufferSize) == 0)
+	{
+		while (done < length)
+		{
+			size_t chunk = copyBufferSize;
+			if (chunk > length - done)
+				chunk = length - done;
+
+			ssize_t got = pread(in, buffer, chunk, inOffset + done);
+			if (got <= 0)
+				break;
+			ssize_t written = 0;
+			while (written < got)
+			{
+				ssize_t n = pwrite(out, (char *)buffer + written, got - written, outOffset + done + written);
+				if (n <= 0)
+					break;
+				written += n;
+			}
+			done += written;
+			if (written < got)
+				break;
+		}
+		free(buffer);
+	}
+
+	return done;
+}
+
+
+// Write length zero bytes from the start of the file, for disks that can not
+// be extended sparsely.
+static int fillzeros(int out, unsigned long long length)
+{
+	unsigned long long done = 0;
+	char *buffer = calloc(1, copyBufferSize);
+
+	if (buffer == NULL)
+		return 1;
+
+	while (done < length)
+	{
+		size_t chunk = copyBufferSize;
+		if (chunk > length - done)
+			chunk = length - done;
+		ssize_t n = pwrite(out, buffer, chunk, done);
+		if (n <= 0)
+			break;
+		done += n;
+	}
+
+	free(buffer);
+	return done < length;
+}
+
+
+// Like copydata, but reads what the destination already holds and skips
+// the chunks that did not change. Returns the number of bytes
+// processed; written gets the number of bytes actually written.
+static unsigned long long updatedata(int in, unsigned long long inOffset, int out, unsigned long long outOffset, unsigned long long length, unsigned long long *written)
+{
+	unsigned long long done = 0;
+	char *source = malloc(updateChunkSize);
+	char *current = malloc(updateChunkSize);
+
+	*written = 0;
+	while (source != NULL && current != NULL && done < length)
+	{
+		size_t chunk = updateChunkSize;
+		if (chunk > length - done)
+			chunk = length - done;
+
+		if (pread(in, source, chunk, inOffset + done) != (ssize_t)chunk)
+			break;
+		ssize_t old = pread(out, current, chunk, outOffset + done);
+		if (old != (ssize_t)chunk || memcmp(source, current, chunk) != 0)
+		{
+			if (pwrite(out, source, chunk, outOffset + done) != (ssize_t)chunk)
+				break;
+			*written += chunk;
+		}
+		done += chunk;
+	}
+
+	free(source);
+	free(current);
+	return done;
+}
+
+
+// Byte-wise FNV-1a, chained through hash (fnvOffsetBasis starts a new one)
+static unsigned long long hashdata(const void *data, size_t length, unsigned long long hash)
+{
+	const unsigned char *bytes = data;
+	size_t i;
+
+	for (i = 0; i < length; i++)
+	{
+		hash ^= bytes[i];
+		hash *= fnvPrime;
+	}
+	return hash;
+}
+
+
+static int hashfile(int in, unsigned long long length, unsigned long long *hash)
+{
+	unsigned long long done = 0;
+	char *buffer = malloc(copyBufferSize);
+
+	*hash = fnvOffsetBasis;
+	while (buffer != NULL && done < length)
+	{
+		size_t chunk = copyBufferSize;
+		if (chunk > length - done)
+			chunk = length - done;
+		if (pread(in, buffer, chunk, done) != (ssize_t)chunk)
+			break;
+		*hash = hashdata(buffer, chunk, *hash);
+		done += chunk;
+	}
+
+	free(buffer);
+	return done < length;
+}
+
+
+static double now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static void report(const char *what, unsigned long long bytes, double seconds)
+{
+	double mib = bytes / (1024.0 * 1024.0);
+	if (seconds > 0)
+		printf("%s: %llu bytes in %.3f s (%.1f MiB/s)\n", what, bytes, seconds, mib / seconds);
+	else
+		printf("%s: %llu bytes\n", what, bytes);
+}
+
+
 /* EOF */
@@ -51,6 +51,11 @@ start16:
 
 clearcs:
 
+; Boot trace: TSC at Pure64 entry (only the BSP gets here)
+	rdtsc
+	mov [BootTrace_Entry], eax
+	mov [BootTrace_Entry+4], edx
+
 ; Configure serial port
 	xor dx, dx			; First serial port
 	mov ax, 0000000011100011b	; 9600 baud, no parity, 1 stop bit, 8 data bits
@@ -439,6 +444,11 @@ clearmapnext:
 ; Init of SMP
 	call init_smp
 
+; Boot trace: TSC once the APs are up
+	rdtsc
+	mov [BootTrace_SMP], eax
+	mov [BootTrace_SMP+4], edx
+
 ; Reset the stack to the proper location (was set to 0x8000 previously)
 	mov rsi, [os_LocalAPICAddress]	; We would call os_smp_get_id here but the stack is not ...
 	add rsi, 0x20			; ... yet defined. It is safer to find the value directly.
@@ -605,6 +615,11 @@ clearnext:
 	cmp cx, 0
 	jne clearnext
 
+; Boot trace: TSC right before jumping to the kernel
+	rdtsc
+	mov [BootTrace_Kernel], eax
+	mov [BootTrace_Kernel+4], edx
+
 ; Clear all registers (skip the stack pointer)
 	xor rax, rax
 	xor rbx, rbx
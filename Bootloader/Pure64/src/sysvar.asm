@@ -19,6 +19,11 @@ E820Map:		equ 0x0000000000004000
 InfoMap:		equ 0x0000000000005000
 SystemVariables:	equ 0x0000000000005A00
 VBEModeInfoBlock:	equ 0x0000000000005C00	; 256 bytes
+
+; Boot trace TSC values (InfoMap, free range 0x5048 - 0x505F)
+BootTrace_Entry:	equ InfoMap + 0x48
+BootTrace_SMP:		equ InfoMap + 0x50
+BootTrace_Kernel:	equ InfoMap + 0x58
 ahci_cmdlist:		equ 0x0000000000070000	; 4096 bytes	0x070000 -> 0x071FFF
 ahci_cmdtable:		equ 0x0000000000072000	; 57344 bytes	0x072000 -> 0x07FFFF
 
@@ -0,0 +1,34 @@
+#!/bin/bash
+# Compara el tiempo de boot con los modulos sin comprimir y comprimidos (LZ4).
+# El kernel se compila con BOOT_BENCHMARK para que apague QEMU apenas termina
+# de cargar los modulos y crear init.
+# Uso: ./bootBenchmark.sh [corridas] [modulo extra ...]
+# (el MBR lee 256 KiB: sin comprimir, el payload completo tiene que entrar ahi)
+cd "$(dirname "$0")"
+RUNS=${1:-5}
+shift
+EXTRA="$*"
+
+(cd ../Kernel && make clean > /dev/null && make BOOT_BENCHMARK=1 > /dev/null) || exit 1
+
+for mode in plain lz4; do
+	flags=""
+	[ $mode = lz4 ] && flags="-c"
+	rm -f packedKernel.bin x64BareBonesImage.img
+	make MPFLAGS="$flags" EXTRA_MODULES="$EXTRA" > /dev/null || exit 1
+
+	total=0
+	for i in $(seq $RUNS); do
+		start=$(date +%s%N)
+		timeout 60 qemu-system-x86_64 -drive file=x64BareBonesImage.img,format=raw -m 512 -display none \
+			-device isa-debug-exit,iobase=0xf4,iosize=0x04
+		end=$(date +%s%N)
+		total=$((total + (end - start) / 1000000))
+	done
+	echo "$mode: $(stat -c %s packedKernel.bin) bytes packed, $((total / RUNS)) ms per boot"
+done
+
+# Deja el kernel normal y una imagen sin comprimir
+(cd ../Kernel && make clean > /dev/null && make > /dev/null)
+rm -f packedKernel.bin x64BareBonesImage.img
+make > /dev/null
@@ -8,14 +8,52 @@ GLOBAL _hlt
 
 GLOBAL _irq00Handler
 GLOBAL _irq01Handler
+GLOBAL _irq14Handler
 
 GLOBAL _int80Handler
+GLOBAL _int81Handler
+
+GLOBAL _resumeContext
+GLOBAL _yield
 
 GLOBAL _exception0Handler
+GLOBAL _exception1Handler
+GLOBAL _exception2Handler
+GLOBAL _exception3Handler
+GLOBAL _exception4Handler
+GLOBAL _exception5Handler
+GLOBAL _exception6Handler
+GLOBAL _exception7Handler
+GLOBAL _exception8Handler
+GLOBAL _exception9Handler
+GLOBAL _exception10Handler
+GLOBAL _exception11Handler
+GLOBAL _exception12Handler
+GLOBAL _exception13Handler
+GLOBAL _exception14Handler
+GLOBAL _exception15Handler
+GLOBAL _exception16Handler
+GLOBAL _exception17Handler
+GLOBAL _exception18Handler
+GLOBAL _exception19Handler
+GLOBAL _exception20Handler
+GLOBAL _exception21Handler
+GLOBAL _exception22Handler
+GLOBAL _exception23Handler
+GLOBAL _exception24Handler
+GLOBAL _exception25Handler
+GLOBAL _exception26Handler
+GLOBAL _exception27Handler
+GLOBAL _exception28Handler
+GLOBAL _exception29Handler
+GLOBAL _exception30Handler
+GLOBAL _exception31Handler
 
 EXTERN irqDispatcher
 EXTERN intDispatcher
 EXTERN exceptionDispatcher
+EXTERN schedule
+EXTERN killCurrentProcess
 
 SECTION .text
 
@@ -38,44 +76,56 @@ SECTION .text
 %endmacro
 
 %macro popState 0
-	pop r15
-	pop r14
-	pop r13
-	pop r12
-	pop r11
-	pop r10
-	pop r9
-	pop r8
-	pop rsi
-	pop rdi
-	pop rbp
-	pop rdx
-	pop rcx
-	pop rbx
 	pop rax
+	pop rbx
+	pop rcx
+	pop rdx
+	pop rbp
+	pop rdi
+	pop rsi
+	pop r8
+	pop r9
+	pop r10
+	pop r11
+	pop r12
+	pop r13
+	pop r14
+	pop r15
 %endmacro
 
 %macro popStateWithoutRax 0
-	pop r15
-	pop r14
-	pop r13
-	pop r12
-	pop r11
-	pop r10
-	pop r9
-	pop r8
-	pop rsi
-	pop rdi
-	pop rbp
-	pop rdx
-	pop rcx
+	add rsp, 8 ; rax conserva el valor de retorno
 	pop rbx
+	pop rcx
+	pop rdx
+	pop rbp
+	pop rdi
+	pop rsi
+	pop r8
+	pop r9
+	pop r10
+	pop r11
+	pop r12
+	pop r13
+	pop r14
+	pop r15
+%endmacro
+
+; El scheduler corre en su propio stack: un exec reescribe el tope del stack de
+; kernel del proceso saliente con su contexto nuevo. Deja en rsp el contexto a
+; retomar.
+%macro schedulerEntry 0
+	mov rdi, rsp
+	mov rsp, schedulerStackTop
+	call schedule
+	mov rsp, rax
 %endmacro
 
 %macro irqHandlerMaster 1
 	pushState
 
 	mov rdi, %1 ; pasaje de parametro
+	mov rsi, rsp ; registers_t *
 	call irqDispatcher
 
 	; signal pic EOI (End of Interrupt)
@@ -86,24 +136,61 @@ SECTION .text
 	iretq
 %endmacro
 
+; Las IRQ 8-15 llegan por el PIC esclavo: hay que avisarle a los dos
+%macro irqHandlerSlave 1
+	pushState
+
+	mov rdi, %1 ; pasaje de parametro
+	mov rsi, rsp ; registers_t *
+	call irqDispatcher
+
+	; signal pic EOI (End of Interrupt)
+	mov al, 20h
+	out 0A0h, al
+	out 20h, al
+
+	popState
+	iretq
+%endmacro
+
+; Las syscalls corren con interrupciones deshabilitadas (kernel no expropiable):
+; las que necesitan esperar se bloquean y ceden el CPU con int 81h.
 %macro intHandlerMaster 0
 	pushState
 	mov rdi, rsp
-	sti
 	call intDispatcher
 
 	popStateWithoutRax
 	iretq
 %endmacro
 
+; Las excepciones sin codigo de error pushean un 0 para que el frame
+; (registers_t + error code + frame del iretq) tenga siempre el mismo layout.
 %macro exceptionHandler 1
+	push qword 0
+	exceptionHandlerWithErrorCode %1
+%endmacro
+
+; Si el dispatcher no pudo resolver la excepcion se mata al proceso actual y se
+; retoma el que elija el scheduler.
+%macro exceptionHandlerWithErrorCode 1
 	pushState
 
 	mov rdi, %1 ; pasaje de parametro
+	mov rsi, rsp ; exception_frame_t *
 	call exceptionDispatcher
+	test rax, rax
+	jz %%fatal
 
 	popState
+	add rsp, 8 ; descartar el codigo de error
 	iretq
+
+%%fatal:
+	mov rsp, schedulerStackTop
+	call killCurrentProcess
+	mov rdi, rax
+	jmp _resumeContext
 %endmacro
 
 
@@ -138,21 +225,179 @@ picSlaveMask:
     retn
 
 
-;8254 Timer (Timer Tick)
+;8254 Timer (Timer Tick): ademas de contar ticks, rota de proceso
 _irq00Handler:
-	irqHandlerMaster 0
+	pushState
+
+	mov rdi, 0
+	mov rsi, rsp ; registers_t *
+	call irqDispatcher
+
+	; signal pic EOI (End of Interrupt)
+	mov al, 20h
+	out 20h, al
+
+	schedulerEntry
+	popState
+	iretq
 
 ;Keyboard
 _irq01Handler:
 	irqHandlerMaster 1
 
+;Disco ATA primario (fin de una transferencia DMA)
+_irq14Handler:
+	irqHandlerSlave 14
+
 _int80Handler:
 	intHandlerMaster
 
+;Yield: el proceso actual cede el CPU. Llega sin IST, sobre el stack de kernel
+;(o de page faults) en que ya corre el proceso: el frame queda como su contexto
+_int81Handler:
+	pushState
+	schedulerEntry
+	popState
+	iretq
+
+_yield:
+	int 81h
+	ret
+
+; rdi = rsp de un interrupt_frame_t
+_resumeContext:
+	mov rsp, rdi
+	popState
+	iretq
+
 ;Zero Division Exception
 _exception0Handler:
 	exceptionHandler 0
 
+;Debug
+_exception1Handler:
+	exceptionHandler 1
+
+;Non Maskable Interrupt
+_exception2Handler:
+	exceptionHandler 2
+
+;Breakpoint
+_exception3Handler:
+	exceptionHandler 3
+
+;Overflow
+_exception4Handler:
+	exceptionHandler 4
+
+;Bound Range Exceeded
+_exception5Handler:
+	exceptionHandler 5
+
+;Invalid Opcode
+_exception6Handler:
+	exceptionHandler 6
+
+;Device Not Available
+_exception7Handler:
+	exceptionHandler 7
+
+;Double Fault
+_exception8Handler:
+	exceptionHandlerWithErrorCode 8
+
+;Coprocessor Segment Overrun
+_exception9Handler:
+	exceptionHandler 9
+
+;Invalid TSS
+_exception10Handler:
+	exceptionHandlerWithErrorCode 10
+
+;Segment Not Present
+_exception11Handler:
+	exceptionHandlerWithErrorCode 11
+
+;Stack-Segment Fault
+_exception12Handler:
+	exceptionHandlerWithErrorCode 12
+
+;General Protection Fault
+_exception13Handler:
+	exceptionHandlerWithErrorCode 13
+
+;Page Fault
+_exception14Handler:
+	exceptionHandlerWithErrorCode 14
+
+;Reserved
+_exception15Handler:
+	exceptionHandler 15
+
+;x87 Floating-Point Exception
+_exception16Handler:
+	exceptionHandler 16
+
+;Alignment Check
+_exception17Handler:
+	exceptionHandlerWithErrorCode 17
+
+;Machine Check
+_exception18Handler:
+	exceptionHandler 18
+
+;SIMD Floating-Point Exception
+_exception19Handler:
+	exceptionHandler 19
+
+;Virtualization Exception
+_exception20Handler:
+	exceptionHandler 20
+
+;Control Protection Exception
+_exception21Handler:
+	exceptionHandlerWithErrorCode 21
+
+;Reserved
+_exception22Handler:
+	exceptionHandler 22
+
+;Reserved
+_exception23Handler:
+	exceptionHandler 23
+
+;Reserved
+_exception24Handler:
+	exceptionHandler 24
+
+;Reserved
+_exception25Handler:
+	exceptionHandler 25
+
+;Reserved
+_exception26Handler:
+	exceptionHandler 26
+
+;Reserved
+_exception27Handler:
+	exceptionHandler 27
+
+;Reserved
+_exception28Handler:
+	exceptionHandler 28
+
+;VMM Communication Exception
+_exception29Handler:
+	exceptionHandlerWithErrorCode 29
+
+;Security Exception
+_exception30Handler:
+	exceptionHandlerWithErrorCode 30
+
+;Reserved
+_exception31Handler:
+	exceptionHandler 31
+
 haltcpu:
 	cli
 	hlt
@@ -161,4 +406,8 @@ haltcpu:
 
 
 SECTION .bss
-	aux resq 1
\ No newline at end of file
+	aux resq 1
+
+	alignb 16
+	schedulerStack resb 4096
+schedulerStackTop:
\ No newline at end of file
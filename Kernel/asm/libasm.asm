@@ -1,4 +1,25 @@
 GLOBAL cpuVendor
+GLOBAL readCR0
+GLOBAL writeCR0
+GLOBAL readCR2
+GLOBAL readCR3
+GLOBAL writeCR3
+GLOBAL readCR4
+GLOBAL writeCR4
+GLOBAL invalidatePage
+GLOBAL _cpuid
+GLOBAL loadGDT
+GLOBAL loadTR
+GLOBAL readMSR
+GLOBAL writeMSR
+GLOBAL outb
+GLOBAL inb
+GLOBAL outw
+GLOBAL inw
+GLOBAL insw
+GLOBAL outl
+GLOBAL inl
+GLOBAL readTSC
 
 section .text
 	
@@ -25,3 +46,138 @@ cpuVendor:
 	mov rsp, rbp
 	pop rbp
 	ret
+
+readCR0:
+	mov rax, cr0
+	ret
+
+writeCR0:
+	mov cr0, rdi
+	ret
+
+; Direccion lineal que provoco el ultimo page fault
+readCR2:
+	mov rax, cr2
+	ret
+
+readCR3:
+	mov rax, cr3
+	ret
+
+writeCR3:
+	mov cr3, rdi
+	ret
+
+readCR4:
+	mov rax, cr4
+	ret
+
+writeCR4:
+	mov cr4, rdi
+	ret
+
+; Invalida la entrada de la TLB que traduce la direccion recibida
+invalidatePage:
+	invlpg [rdi]
+	ret
+
+; void _cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
+; Devuelve eax, ebx, ecx, edx en ese orden
+_cpuid:
+	push rbx
+
+	mov eax, edi
+	mov ecx, esi
+	mov r8, rdx
+	cpuid
+	mov [r8], eax
+	mov [r8 + 4], ebx
+	mov [r8 + 8], ecx
+	mov [r8 + 12], edx
+
+	pop rbx
+	ret
+
+; Los selectores no cambian respecto de los de Pure64, no hace falta recargarlos
+loadGDT:
+	lgdt [rdi]
+	ret
+
+loadTR:
+	ltr di
+	ret
+
+; uint64_t readMSR(uint32_t msr)
+readMSR:
+	mov ecx, edi
+	rdmsr
+	shl rdx, 32
+	or rax, rdx
+	ret
+
+; void writeMSR(uint32_t msr, uint64_t value)
+writeMSR:
+	mov ecx, edi
+	mov rax, rsi
+	mov rdx, rsi
+	shr rdx, 32
+	wrmsr
+	ret
+
+; void outb(uint16_t port, uint8_t value)
+outb:
+	mov dx, di
+	mov al, sil
+	out dx, al
+	ret
+
+; uint8_t inb(uint16_t port)
+inb:
+	mov dx, di
+	xor rax, rax
+	in al, dx
+	ret
+
+; void outw(uint16_t port, uint16_t value)
+outw:
+	mov dx, di
+	mov ax, si
+	out dx, ax
+	ret
+
+; uint16_t inw(uint16_t port)
+inw:
+	mov dx, di
+	xor rax, rax
+	in ax, dx
+	ret
+
+; void insw(uint16_t port, void *buffer, uint64_t count)
+; Lee count words del puerto al buffer (un sector ATA son 256)
+insw:
+	mov dx, di
+	mov rdi, rsi
+	mov rcx, rdx
+	cld
+	rep insw
+	ret
+
+; void outl(uint16_t port, uint32_t value)
+outl:
+	mov dx, di
+	mov eax, esi
+	out dx, eax
+	ret
+
+; uint32_t inl(uint16_t port)
+inl:
+	mov dx, di
+	in eax, dx
+	ret
+
+; uint64_t readTSC(void)
+readTSC:
+	rdtsc
+	shl rdx, 32
+	or rax, rdx
+	ret
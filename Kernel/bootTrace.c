@@ -0,0 +1,72 @@
+#include <stdint.h>
+#include <bootTrace.h>
+#include <naiveConsole.h>
+#include <lib.h>
+#include <time.h>
+
+// Lo que Pure64 deja en el InfoMap
+#define PURE64_TSC_ENTRY ((uint64_t *)0x5048)
+#define PURE64_TSC_SMP ((uint64_t *)0x5050)
+#define PURE64_TSC_KERNEL ((uint64_t *)0x5058)
+
+typedef struct {
+	const char *name;
+	uint64_t tsc;
+} boot_point_t;
+
+// TSC al entrar al loader; en .data para sobrevivir al borrado del .bss
+extern uint64_t loaderTSC;
+
+static boot_point_t points[BOOT_TRACE_MAX];
+static uint64_t count;
+
+void boot_trace_at(const char *name, uint64_t tsc) {
+	// Un Pure64 viejo no deja los suyos
+	if (count == BOOT_TRACE_MAX || tsc == 0)
+		return;
+	points[count].name = name;
+	points[count].tsc = tsc;
+	count++;
+}
+
+void boot_trace(const char *name) {
+	boot_trace_at(name, readTSC());
+}
+
+void boot_trace_init(void) {
+	boot_trace_at("pure64", *PURE64_TSC_ENTRY);
+	boot_trace_at("pure64 smp", *PURE64_TSC_SMP);
+	boot_trace_at("pure64 jump", *PURE64_TSC_KERNEL);
+	boot_trace_at("loader", loaderTSC);
+}
+
+void boot_trace_print(void) {
+	ncPrint("Boot trace (us since previous):");
+	ncNewline();
+	for (uint64_t i = 0; i < count; i++) {
+		ncPrint("  ");
+		ncPrint(points[i].name);
+		ncPrint(": ");
+		ncPrintDec(i == 0 ? 0 : cycles_to_microseconds(points[i].tsc - points[i - 1].tsc));
+		ncNewline();
+	}
+	ncPrint("  total: ");
+	ncPrintDec(count == 0 ? 0 : cycles_to_microseconds(points[count - 1].tsc - points[0].tsc));
+	ncPrint(" us");
+	ncNewline();
+}
+
+uint64_t boot_trace_read(boot_trace_record_t *buffer, uint64_t max) {
+	uint64_t copied = max < count ? max : count;
+
+	for (uint64_t i = 0; i < copied; i++) {
+		uint64_t length = 0;
+		while (length < BOOT_TRACE_NAME_LENGTH - 1 && points[i].name[length] != 0)
+			length++;
+		memset(buffer[i].name, 0, BOOT_TRACE_NAME_LENGTH);
+		memcpy(buffer[i].name, points[i].name, length);
+		buffer[i].tsc = points[i].tsc;
+		buffer[i].microseconds = cycles_to_microseconds(points[i].tsc - points[0].tsc);
+	}
+	return copied;
+}
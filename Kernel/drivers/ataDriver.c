@@ -0,0 +1,222 @@
+#include <stdint.h>
+#include <ataDriver.h>
+#include <lib.h>
+#include <pci.h>
+#include <pmm.h>
+
+// Bus primario, la unidad master es el disco de -hda en QEMU
+#define ATA_DATA 0x1F0
+#define ATA_SECTOR_COUNT 0x1F2
+#define ATA_LBA_LOW 0x1F3
+#define ATA_LBA_MID 0x1F4
+#define ATA_LBA_HIGH 0x1F5
+#define ATA_DRIVE 0x1F6
+#define ATA_STATUS 0x1F7
+#define ATA_COMMAND 0x1F7
+#define ATA_CONTROL 0x3F6
+
+#define ATA_STATUS_ERR 0x01
+#define ATA_STATUS_DRQ 0x08
+#define ATA_STATUS_DF 0x20
+#define ATA_STATUS_BSY 0x80
+
+#define ATA_CONTROL_NIEN 0x02           // sin IRQ 14: el driver hace polling
+#define ATA_DRIVE_MASTER_LBA 0x40
+
+#define ATA_CMD_READ_SECTORS_EXT 0x24
+#define ATA_CMD_READ_DMA_EXT 0x25
+#define ATA_CMD_WRITE_DMA_EXT 0x35
+#define ATA_CMD_IDENTIFY 0xEC
+
+#define IDENTIFY_LBA28_SECTORS 60       // words 60-61
+#define IDENTIFY_LBA48_SECTORS 100      // words 100-103
+#define MAX_SECTORS_PER_COMMAND 65536   // un sector count de 0 significa 65536
+
+// Bus master del canal primario, a partir del BAR4 del controlador IDE
+#define BM_COMMAND 0x0
+#define BM_STATUS 0x2
+#define BM_PRDT 0x4
+
+#define BM_COMMAND_START 0x01
+#define BM_COMMAND_TO_MEMORY 0x08           // lectura del disco
+#define BM_STATUS_ACTIVE 0x01
+#define BM_STATUS_ERROR 0x02
+#define BM_STATUS_IRQ 0x04
+
+#define PCI_CLASS_STORAGE 0x01
+#define PCI_SUBCLASS_IDE 0x01
+
+#define PRD_END_OF_TABLE 0x8000
+#define DMA_LIMIT 0x100000000ULL            // las direcciones de la PRD son de 32 bits
+#define DMA_BOUNDARY 0x10000
+
+typedef struct {
+	uint32_t address;
+	uint16_t length;                        // 0 significa 64 KiB
+	uint16_t flags;
+} __attribute__((packed)) prd_entry_t;
+
+static uint64_t sector_count;
+static uint16_t bus_master = 0;             // 0 si no hay DMA
+static uint64_t prd_table;                  // fisica
+
+// Leer el status alternativo cuatro veces da los 400ns que pide el estandar
+static void delay_400ns(void) {
+	for (int i = 0; i < 4; i++)
+		inb(ATA_CONTROL);
+}
+
+static int wait_data(void) {
+	uint8_t status;
+
+	delay_400ns();
+	while ((status = inb(ATA_STATUS)) & ATA_STATUS_BSY)
+		;
+
+	if (status & (ATA_STATUS_ERR | ATA_STATUS_DF))
+		return -1;
+	return (status & ATA_STATUS_DRQ) ? 0 : -1;
+}
+
+int ata_init(void) {
+	uint16_t identify[256];
+
+	outb(ATA_CONTROL, ATA_CONTROL_NIEN);
+	outb(ATA_DRIVE, 0xA0);
+	outb(ATA_SECTOR_COUNT, 0);
+	outb(ATA_LBA_LOW, 0);
+	outb(ATA_LBA_MID, 0);
+	outb(ATA_LBA_HIGH, 0);
+	outb(ATA_COMMAND, ATA_CMD_IDENTIFY);
+
+	// Status 0: no hay unidad. LBA mid/high distinto de 0: es ATAPI o SATA
+	if (inb(ATA_STATUS) == 0 || inb(ATA_LBA_MID) != 0 || inb(ATA_LBA_HIGH) != 0 || wait_data() != 0) {
+		sector_count = 0;
+		return -1;
+	}
+
+	insw(ATA_DATA, identify, 256);
+	sector_count = *(uint64_t *)&identify[IDENTIFY_LBA48_SECTORS];
+	if (sector_count == 0)
+		sector_count = *(uint32_t *)&identify[IDENTIFY_LBA28_SECTORS];
+	return 0;
+}
+
+uint64_t ata_sector_count(void) {
+	return sector_count;
+}
+
+static void lba48_command(uint64_t lba, uint32_t sectors, uint8_t command) {
+	outb(ATA_DRIVE, ATA_DRIVE_MASTER_LBA);
+
+	// LBA48: primero los bytes altos de cada registro y despues los bajos
+	outb(ATA_SECTOR_COUNT, (sectors >> 8) & 0xFF);
+	outb(ATA_LBA_LOW, (lba >> 24) & 0xFF);
+	outb(ATA_LBA_MID, (lba >> 32) & 0xFF);
+	outb(ATA_LBA_HIGH, (lba >> 40) & 0xFF);
+	outb(ATA_SECTOR_COUNT, sectors & 0xFF);
+	outb(ATA_LBA_LOW, lba & 0xFF);
+	outb(ATA_LBA_MID, (lba >> 8) & 0xFF);
+	outb(ATA_LBA_HIGH, (lba >> 16) & 0xFF);
+
+	outb(ATA_COMMAND, command);
+}
+
+int ata_read_pages(uint64_t lba, void **pages, uint32_t count) {
+	uint64_t sectors = (uint64_t)count * ATA_SECTORS_PER_PAGE;
+
+	if (sector_count == 0 || lba + sectors > sector_count)
+		return -1;
+
+	for (uint64_t done = 0; done < sectors; ) {
+		uint32_t chunk = sectors - done > MAX_SECTORS_PER_COMMAND ? MAX_SECTORS_PER_COMMAND : sectors - done;
+		lba48_command(lba + done, chunk, ATA_CMD_READ_SECTORS_EXT);
+
+		// Un DRQ por sector; los sectores van llenando las paginas en orden
+		for (uint32_t i = 0; i < chunk; i++, done++) {
+			if (wait_data() != 0)
+				return -1;
+			uint8_t *page = pages[done / ATA_SECTORS_PER_PAGE];
+			insw(ATA_DATA, page + (done % ATA_SECTORS_PER_PAGE) * ATA_SECTOR_SIZE, ATA_SECTOR_SIZE / 2);
+		}
+	}
+	return 0;
+}
+
+//=============================================================================
+// BUS MASTER DMA
+//=============================================================================
+
+int ata_dma_init(void) {
+	pci_device_t controller;
+
+	if (sector_count == 0 || pci_find_class(PCI_CLASS_STORAGE, PCI_SUBCLASS_IDE, &controller) != 0)
+		return -1;
+
+	uint32_t bar4 = pci_read(controller, PCI_BAR4);
+	prd_table = pmm_alloc_frame();
+	if (!(bar4 & 0x1) || prd_table == 0 || prd_table >= DMA_LIMIT) {
+		pmm_free_frame(prd_table);
+		return -1;
+	}
+
+	pci_write(controller, PCI_COMMAND, pci_read(controller, PCI_COMMAND) | PCI_COMMAND_IO | PCI_COMMAND_BUS_MASTER);
+	bus_master = bar4 & 0xFFFC;
+
+	outb(bus_master + BM_COMMAND, 0);
+	outb(bus_master + BM_STATUS, BM_STATUS_ERROR | BM_STATUS_IRQ);
+	outl(bus_master + BM_PRDT, prd_table);
+
+	// El fin de cada transferencia se avisa por IRQ 14
+	outb(ATA_CONTROL, 0);
+	return 0;
+}
+
+int ata_dma_available(void) {
+	return bus_master != 0;
+}
+
+int ata_dma_start(uint64_t lba, uint32_t sectors, int write, const dma_segment_t *segments, uint32_t count) {
+	prd_entry_t *prd = P2V(prd_table);
+
+	if (bus_master == 0 || count == 0 || count > ATA_MAX_DMA_SEGMENTS
+			|| sectors == 0 || sectors > ATA_MAX_DMA_SECTORS || lba + sectors > sector_count)
+		return -1;
+
+	for (uint32_t i = 0; i < count; i++) {
+		uint64_t address = segments[i].address;
+		uint32_t length = segments[i].length;
+
+		if (length == 0 || length > DMA_BOUNDARY || address + length > DMA_LIMIT || (address & 1) || (length & 1)
+				|| address / DMA_BOUNDARY != (address + length - 1) / DMA_BOUNDARY)
+			return -1;
+
+		prd[i].address = address;
+		prd[i].length = length & 0xFFFF;
+		prd[i].flags = i == count - 1 ? PRD_END_OF_TABLE : 0;
+	}
+
+	outb(bus_master + BM_COMMAND, write ? 0 : BM_COMMAND_TO_MEMORY);
+	outb(bus_master + BM_STATUS, BM_STATUS_ERROR | BM_STATUS_IRQ);
+	outl(bus_master + BM_PRDT, prd_table);
+
+	lba48_command(lba, sectors, write ? ATA_CMD_WRITE_DMA_EXT : ATA_CMD_READ_DMA_EXT);
+	outb(bus_master + BM_COMMAND, (write ? 0 : BM_COMMAND_TO_MEMORY) | BM_COMMAND_START);
+	return 0;
+}
+
+int ata_dma_finish(void) {
+	if (bus_master == 0)
+		return 1;
+
+	uint8_t bm_status = inb(bus_master + BM_STATUS);
+	if (!(bm_status & BM_STATUS_IRQ))
+		return 1;
+
+	outb(bus_master + BM_COMMAND, 0);
+	outb(bus_master + BM_STATUS, BM_STATUS_ERROR | BM_STATUS_IRQ);
+
+	// Leer el status del dispositivo baja su linea de interrupcion
+	uint8_t status = inb(ATA_STATUS);
+	return (bm_status & BM_STATUS_ERROR) || (status & (ATA_STATUS_ERR | ATA_STATUS_DF)) ? -1 : 0;
+}
@@ -0,0 +1,91 @@
+#include <stdint.h>
+#include <bgaDriver.h>
+#include <lib.h>
+
+#define BGA_INDEX_PORT 0x1CE
+#define BGA_DATA_PORT 0x1CF
+
+// Registros (se elige con el indice y se accede por el puerto de datos)
+#define BGA_ID 0x0
+#define BGA_XRES 0x1
+#define BGA_YRES 0x2
+#define BGA_BPP 0x3
+#define BGA_ENABLE 0x4
+#define BGA_VIRT_WIDTH 0x6
+#define BGA_VIRT_HEIGHT 0x7
+#define BGA_X_OFFSET 0x8
+#define BGA_Y_OFFSET 0x9
+
+#define BGA_ID_MIN 0xB0C0
+#define BGA_ID_MAX 0xB0CF
+
+#define BGA_ENABLED 0x01
+#define BGA_LFB_ENABLED 0x40
+#define BGA_NO_CLEAR_MEM 0x80
+
+static int present = 0;
+
+static void write_register(uint16_t index, uint16_t value) {
+	outw(BGA_INDEX_PORT, index);
+	outw(BGA_DATA_PORT, value);
+}
+
+static uint16_t read_register(uint16_t index) {
+	outw(BGA_INDEX_PORT, index);
+	return inw(BGA_DATA_PORT);
+}
+
+// El adaptador recorta lo que pide de mas a lo que entra en la memoria de video
+static void grow_virtual_height(void) {
+	write_register(BGA_VIRT_HEIGHT, 0xFFFF);
+	write_register(BGA_X_OFFSET, 0);
+	write_register(BGA_Y_OFFSET, 0);
+}
+
+static int program_mode(uint16_t width, uint16_t height, uint16_t bpp) {
+	write_register(BGA_ENABLE, 0);
+	write_register(BGA_XRES, width);
+	write_register(BGA_YRES, height);
+	write_register(BGA_BPP, bpp);
+	// Sin borrar la memoria: si el modo no se acepta, se vuelve al anterior intacto
+	write_register(BGA_ENABLE, BGA_ENABLED | BGA_LFB_ENABLED | BGA_NO_CLEAR_MEM);
+
+	return read_register(BGA_XRES) == width && read_register(BGA_YRES) == height && read_register(BGA_BPP) == bpp;
+}
+
+int bga_init(void) {
+	uint16_t id = read_register(BGA_ID);
+	if (id < BGA_ID_MIN || id > BGA_ID_MAX)
+		return -1;
+
+	present = 1;
+	grow_virtual_height();
+	return 0;
+}
+
+int bga_set_mode(uint16_t width, uint16_t height, uint16_t bpp) {
+	if (!present)
+		return -1;
+
+	uint16_t old_width = read_register(BGA_XRES);
+	uint16_t old_height = read_register(BGA_YRES);
+	uint16_t old_bpp = read_register(BGA_BPP);
+
+	if (!program_mode(width, height, bpp)) {
+		program_mode(old_width, old_height, old_bpp);
+		grow_virtual_height();
+		return -1;
+	}
+	grow_virtual_height();
+	return 0;
+}
+
+void bga_get_geometry(uint32_t *pitch, uint32_t *virtual_height) {
+	*pitch = (uint32_t)read_register(BGA_VIRT_WIDTH) * ((read_register(BGA_BPP) + 7) / 8);
+	*virtual_height = read_register(BGA_VIRT_HEIGHT);
+}
+
+void bga_set_y_offset(uint16_t y) {
+	if (present)
+		write_register(BGA_Y_OFFSET, y);
+}
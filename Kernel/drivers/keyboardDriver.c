@@ -0,0 +1,53 @@
+#include <stdint.h>
+#include <keyboardDriver.h>
+#include <videoDriver.h>
+#include <lib.h>
+
+#define KEYBOARD_DATA_PORT 0x60
+
+// Scan codes (set 1): el bit 7 indica que la tecla se solto
+#define SCAN_RELEASED 0x80
+#define SCAN_EXTENDED 0xE0
+#define SCAN_LEFT_SHIFT 0x2A
+#define SCAN_RIGHT_SHIFT 0x36
+#define SCAN_ALT 0x38                       // el derecho con prefijo 0xE0
+#define SCAN_F1 0x3B                        // F1 a F10 son consecutivas
+#define SCAN_F10 0x44
+#define SCAN_PAGE_UP 0x49                   // con prefijo 0xE0
+#define SCAN_PAGE_DOWN 0x51                 // con prefijo 0xE0
+
+static uint8_t extended = 0;
+static uint8_t left_shift = 0;
+static uint8_t right_shift = 0;
+static uint8_t left_alt = 0;
+static uint8_t right_alt = 0;
+
+void keyboard_irq_handler(void) {
+	uint8_t scan = inb(KEYBOARD_DATA_PORT);
+
+	if (scan == SCAN_EXTENDED) {
+		extended = 1;
+		return;
+	}
+
+	uint8_t released = scan & SCAN_RELEASED;
+	uint8_t key = scan & ~SCAN_RELEASED;
+	uint8_t was_extended = extended;
+	extended = 0;
+
+	// Con prefijo, 0x2A/0x36 son shifts falsos que mandan algunas teclas
+	if (!was_extended && key == SCAN_LEFT_SHIFT)
+		left_shift = !released;
+	else if (!was_extended && key == SCAN_RIGHT_SHIFT)
+		right_shift = !released;
+	else if (key == SCAN_ALT && !was_extended)
+		left_alt = !released;
+	else if (key == SCAN_ALT)
+		right_alt = !released;
+	else if (!was_extended && !released && (left_alt || right_alt) && key >= SCAN_F1 && key <= SCAN_F10)
+		switch_console(key - SCAN_F1);
+	else if (was_extended && !released && (left_shift || right_shift) && key == SCAN_PAGE_UP)
+		scroll_text_view(-1);
+	else if (was_extended && !released && (left_shift || right_shift) && key == SCAN_PAGE_DOWN)
+		scroll_text_view(1);
+}
@@ -0,0 +1,49 @@
+#include <stdint.h>
+#include <pci.h>
+#include <lib.h>
+
+#define PCI_CONFIG_ADDRESS 0xCF8
+#define PCI_CONFIG_DATA 0xCFC
+#define PCI_ENABLE (1U << 31)
+
+#define PCI_VENDOR_NONE 0xFFFF
+#define PCI_HEADER_TYPE 0x0C                // byte 2: bit 7 multifuncion
+
+static uint32_t address(pci_device_t device, uint8_t offset) {
+	return PCI_ENABLE | (device.bus << 16) | (device.device << 11) | (device.function << 8) | (offset & 0xFC);
+}
+
+uint32_t pci_read(pci_device_t device, uint8_t offset) {
+	outl(PCI_CONFIG_ADDRESS, address(device, offset));
+	return inl(PCI_CONFIG_DATA);
+}
+
+void pci_write(pci_device_t device, uint8_t offset, uint32_t value) {
+	outl(PCI_CONFIG_ADDRESS, address(device, offset));
+	outl(PCI_CONFIG_DATA, value);
+}
+
+int pci_find_class(uint8_t class_code, uint8_t subclass, pci_device_t *found) {
+	for (int bus = 0; bus < 256; bus++) {
+		for (int slot = 0; slot < 32; slot++) {
+			for (int function = 0; function < 8; function++) {
+				pci_device_t device = { bus, slot, function };
+				if ((pci_read(device, 0) & 0xFFFF) == PCI_VENDOR_NONE) {
+					if (function == 0)
+						break;
+					continue;
+				}
+
+				uint32_t class = pci_read(device, PCI_CLASS);
+				if ((class >> 24) == class_code && ((class >> 16) & 0xFF) == subclass) {
+					*found = device;
+					return 0;
+				}
+
+				if (function == 0 && !(pci_read(device, PCI_HEADER_TYPE) & (0x80 << 16)))
+					break;
+			}
+		}
+	}
+	return -1;
+}
@@ -3,6 +3,8 @@
 #include <font.h>
 #include <lib.h>
 #include <interrupts.h>
+#include <bgaDriver.h>
+#include <pmm.h>
 
 //=============================================================================
 // VBE MODE INFORMATION STRUCTURE
@@ -50,19 +52,431 @@ typedef struct vbe_mode_info_structure * VBEInfoPtr;
 
 VBEInfoPtr VBE_mode_info = (VBEInfoPtr) 0x0000000000005C00;
 
+//=============================================================================
+// VIDEO MEMORY PANNING
+//=============================================================================
+
+static uint32_t screen_top = 0;         // first line of video memory shown on screen
+static uint32_t virtual_height = 0;     // lines of video memory, at least the screen height
+
 //=============================================================================
 // TEXT BUFFER FOR RE-RENDERING
 //=============================================================================
 
+// One line of text: glyphs and colors in separate arrays, 2 bytes per cell
+typedef struct {
+    uint8_t glyphs[SCREEN_TEXT_BUFFER_WIDTH];
+    uint8_t colors[SCREEN_TEXT_BUFFER_WIDTH];  // index into palette
+} TextLine;
+
+// Colors used by the text, referenced by index from the cells
+#define PALETTE_SIZE 256
+static uint32_t palette[PALETTE_SIZE] = { 0xFFFFFF };
+static uint32_t palette_count = 1;
+static uint8_t last_color = 0;          // palette index of the last color looked up
+
+// Scrollback history: a ring of lines kept in whole frames
+#define LINES_PER_BLOCK (PAGE_SIZE / sizeof(TextLine))
+#define MAX_HISTORY_BLOCKS 256          // per console
+#define HISTORY_MEMORY_SHARE 32         // all consoles together, at most 1/32 of the free frames
+
+// Frames holding a copy of the screen, enough for 1920x1080 at 32 bpp
+#define MAX_CACHE_PAGES 2048
+
+// A virtual console: its own text, cursor and font, and the screen as it
+// looked when it was last hidden
+typedef struct {
+    TextLine **history_blocks;
+    uint64_t history_lines;             // lines in the ring, 0 while boot_history is used
+
+    // Lines are numbered from the first one written and never renumbered
+    uint32_t cursor_x;
+    uint64_t cursor_line;
+    uint64_t first_line;                // oldest line the ring may still hold
+    uint64_t last_line;                 // newest line written
+    uint64_t view_line;                 // first line shown while paging back
+    int following;                      // the view follows the cursor
+    uint32_t font_size;
+    uint64_t shown_line;                // first text line on screen
+    uint64_t dirty_from;                // text lines changed since the last update
+    uint64_t dirty_to;
+    int dirty;
+
+    uint8_t **cache;
+    uint64_t cache_pages;               // frames allocated for the cache
+    int cached;                         // the cache holds the screen of shown_line
+} console_t;
+
+// Until video_init allocates the history, the text of console 0 goes here
+static TextLine boot_history[SCREEN_TEXT_BUFFER_HEIGHT];
+static TextLine *history_blocks[MAX_CONSOLES][MAX_HISTORY_BLOCKS];
+static uint8_t *cache_frames[MAX_CONSOLES][MAX_CACHE_PAGES];
+
+#define CONSOLE(i) { .history_blocks = history_blocks[i], .cache = cache_frames[i], .following = 1, .font_size = 1 }
+
+static console_t consoles[MAX_CONSOLES] = { CONSOLE(0), CONSOLE(1), CONSOLE(2), CONSOLE(3) };
+static console_t *active = &consoles[0];        // the only console drawn to the screen
+
+//=============================================================================
+// PIXEL FORMATS
+//=============================================================================
+
+// Drawing routines for one pixel format. Pixels are already in the native format
+typedef struct {
+    void (*store_pixel)(uint8_t *pixel, uint32_t native);
+    void (*fill_span)(uint8_t *row, uint64_t count, uint32_t native);
+    void (*blit_span)(uint8_t *row, const uint32_t *source, uint64_t count);
+} pixel_routines_t;
+
+// How a 0xRRGGBB channel is placed in a native pixel
 typedef struct {
-    char c;
-    uint32_t color;
-} TextChar;
+    uint8_t drop;           // low bits the format does not keep
+    uint8_t position;
+} channel_t;
+
+static void store_pixel16(uint8_t *pixel, uint32_t native);
+static void store_pixel24(uint8_t *pixel, uint32_t native);
+static void store_pixel32(uint8_t *pixel, uint32_t native);
+static void fill_span16(uint8_t *row, uint64_t count, uint32_t native);
+static void fill_span24(uint8_t *row, uint64_t count, uint32_t native);
+static void fill_span32(uint8_t *row, uint64_t count, uint32_t native);
+static void blit_span16(uint8_t *row, const uint32_t *source, uint64_t count);
+static void blit_span24(uint8_t *row, const uint32_t *source, uint64_t count);
+static void blit_span32(uint8_t *row, const uint32_t *source, uint64_t count);
+static void blit_span32_direct(uint8_t *row, const uint32_t *source, uint64_t count);
+
+// Until video_init selects them: the 24 bpp BGR format the driver always assumed
+static pixel_routines_t pixel_routines = { store_pixel24, fill_span24, blit_span24 };
+static uint32_t bytes_per_pixel = 3;
+static channel_t red = { 0, 16 }, green = { 0, 8 }, blue = { 0, 0 };
+
+/**
+ * Converts a 0xRRGGBB color to the native pixel format
+ */
+static uint32_t native_color(uint32_t hexColor) {
+    return ((hexColor >> 16 & 0xFF) >> red.drop) << red.position
+         | ((hexColor >> 8 & 0xFF) >> green.drop) << green.position
+         | ((hexColor & 0xFF) >> blue.drop) << blue.position;
+}
+
+static void store_pixel16(uint8_t *pixel, uint32_t native) {
+    *(uint16_t*)pixel = native;
+}
+
+static void store_pixel24(uint8_t *pixel, uint32_t native) {
+    pixel[0] = native;
+    pixel[1] = native >> 8;
+    pixel[2] = native >> 16;
+}
+
+static void store_pixel32(uint8_t *pixel, uint32_t native) {
+    *(uint32_t*)pixel = native;
+}
+
+/**
+ * Fills a 16 bpp span two pixels per word store
+ */
+static void fill_span16(uint8_t *row, uint64_t count, uint32_t native) {
+    uint16_t *pixels = (uint16_t*)row;
+    if (count > 0 && (uint64_t)pixels % 4 != 0) {
+        *pixels++ = native;
+        count--;
+    }
+
+    uint32_t *words = (uint32_t*)pixels;
+    uint32_t pair = native | native << 16;
+    for (; count >= 2; count -= 2)
+        *words++ = pair;
+
+    if (count > 0) *(uint16_t*)words = native;
+}
+
+/**
+ * Fills a 24 bpp span four pixels (three words) at a time
+ */
+static void fill_span24(uint8_t *row, uint64_t count, uint32_t native) {
+    uint32_t *words = (uint32_t*)row;
+    uint32_t first = native | native << 24;
+    uint32_t second = native >> 8 | native << 16;
+    uint32_t third = native >> 16 | native << 8;
+    for (; count >= 4; count -= 4) {
+        *words++ = first;
+        *words++ = second;
+        *words++ = third;
+    }
+
+    row = (uint8_t*)words;
+    for (; count > 0; count--, row += 3)
+        store_pixel24(row, native);
+}
+
+static void fill_span32(uint8_t *row, uint64_t count, uint32_t native) {
+    uint32_t *pixels = (uint32_t*)row;
+    for (uint64_t i = 0; i < count; i++)
+        pixels[i] = native;
+}
+
+static void blit_span16(uint8_t *row, const uint32_t *source, uint64_t count) {
+    uint16_t *pixels = (uint16_t*)row;
+    for (uint64_t i = 0; i < count; i++)
+        pixels[i] = native_color(source[i]);
+}
+
+static void blit_span24(uint8_t *row, const uint32_t *source, uint64_t count) {
+    for (uint64_t i = 0; i < count; i++, row += 3)
+        store_pixel24(row, native_color(source[i]));
+}
+
+static void blit_span32(uint8_t *row, const uint32_t *source, uint64_t count) {
+    uint32_t *pixels = (uint32_t*)row;
+    for (uint64_t i = 0; i < count; i++)
+        pixels[i] = native_color(source[i]);
+}
+
+/**
+ * Copies a 32 bpp span whose native format is already 0xRRGGBB
+ */
+static void blit_span32_direct(uint8_t *row, const uint32_t *source, uint64_t count) {
+    memcpy(row, source, count * sizeof(uint32_t));
+}
+
+/**
+ * Reads where a channel goes from the VBE mask size and position
+ */
+static channel_t vbe_channel(uint8_t size, uint8_t position) {
+    channel_t channel = { size < 8 ? 8 - size : 0, position };
+    return channel;
+}
+
+/**
+ * Selects the drawing routines and color conversion for the current mode
+ */
+static void select_pixel_format() {
+    bytes_per_pixel = (VBE_mode_info->bpp + 7) / 8;
+    red = vbe_channel(VBE_mode_info->red_mask, VBE_mode_info->red_position);
+    green = vbe_channel(VBE_mode_info->green_mask, VBE_mode_info->green_position);
+    blue = vbe_channel(VBE_mode_info->blue_mask, VBE_mode_info->blue_position);
+
+    // Some BIOSes leave the masks empty for 24/32 bpp modes: assume 8:8:8
+    int missing_mask = VBE_mode_info->red_mask == 0 || VBE_mode_info->green_mask == 0 || VBE_mode_info->blue_mask == 0;
+    if (bytes_per_pixel >= 3 && missing_mask) {
+        red = (channel_t){ 0, 16 };
+        green = (channel_t){ 0, 8 };
+        blue = (channel_t){ 0, 0 };
+    }
+
+    switch (bytes_per_pixel) {
+        case 2:
+            pixel_routines = (pixel_routines_t){ store_pixel16, fill_span16, blit_span16 };
+            break;
+        case 4:
+            pixel_routines = (pixel_routines_t){ store_pixel32, fill_span32, blit_span32 };
+            if (native_color(0xFFFFFF) == 0xFFFFFF && native_color(0x123456) == 0x123456)
+                pixel_routines.blit_span = blit_span32_direct;
+            break;
+        default:
+            pixel_routines = (pixel_routines_t){ store_pixel24, fill_span24, blit_span24 };
+            break;
+    }
+}
+
+//=============================================================================
+// SPAN ROUTINES
+//=============================================================================
+
+/**
+ * Gets the address of a screen pixel inside the framebuffer
+ */
+static uint8_t *pixel_address(int64_t x, int64_t y) {
+    return (uint8_t*)(uint64_t)VBE_mode_info->framebuffer + (y + screen_top) * VBE_mode_info->pitch + x * bytes_per_pixel;
+}
+
+/**
+ * Clips a rectangle to the screen. Returns 0 if nothing is left, otherwise
+ * how many columns and rows were cut from the left and the top
+ */
+static int clip_rect(int64_t *x, int64_t *y, int64_t *width, int64_t *height, int64_t *skipX, int64_t *skipY) {
+    *skipX = *x < 0 ? -*x : 0;
+    *skipY = *y < 0 ? -*y : 0;
+    *x += *skipX;
+    *y += *skipY;
+    *width -= *skipX;
+    *height -= *skipY;
+
+    if (*x + *width > VBE_mode_info->width) *width = VBE_mode_info->width - *x;
+    if (*y + *height > VBE_mode_info->height) *height = VBE_mode_info->height - *y;
+    return *width > 0 && *height > 0;
+}
 
-static TextChar text_buffer[SCREEN_TEXT_BUFFER_HEIGHT][SCREEN_TEXT_BUFFER_WIDTH];
-static uint32_t cursor_x = 0;
-static uint32_t cursor_y = 0;
-static uint32_t font_size = 1;
+/**
+ * Fills a rectangle with a native pixel, clipped to the screen, one span per row
+ */
+static void fill_native(uint32_t native, int64_t x, int64_t y, int64_t width, int64_t height) {
+    int64_t skipX, skipY;
+    if (!clip_rect(&x, &y, &width, &height, &skipX, &skipY)) return;
+
+    uint8_t *row = pixel_address(x, y);
+    for (int64_t i = 0; i < height; i++, row += VBE_mode_info->pitch)
+        pixel_routines.fill_span(row, width, native);
+}
+
+/**
+ * Fills a rectangle, clipped to the screen
+ */
+static void fill_rect(uint32_t hexColor, int64_t x, int64_t y, int64_t width, int64_t height) {
+    fill_native(native_color(hexColor), x, y, width, height);
+}
+
+/**
+ * Copies a bitmap of 0xRRGGBB pixels to the screen, converting each row to
+ * the native format (or copying it as is when it already matches)
+ */
+static void blit_bitmap(const uint32_t *pixels, uint32_t stride, int64_t x, int64_t y, int64_t width, int64_t height) {
+    int64_t skipX, skipY;
+    if (!clip_rect(&x, &y, &width, &height, &skipX, &skipY)) return;
+
+    const uint32_t *source = pixels + skipY * stride + skipX;
+    uint8_t *row = pixel_address(x, y);
+    for (int64_t i = 0; i < height; i++, source += stride, row += VBE_mode_info->pitch)
+        pixel_routines.blit_span(row, source, width);
+}
+
+/**
+ * Moves a rectangle of the screen. Rows are visited in the order that does
+ * not overwrite rows still to be copied when both rectangles overlap
+ */
+static void copy_rect(int64_t srcX, int64_t srcY, int64_t x, int64_t y, int64_t width, int64_t height) {
+    int64_t skipX, skipY;
+    if (!clip_rect(&x, &y, &width, &height, &skipX, &skipY)) return;
+    srcX += skipX;
+    srcY += skipY;
+    if (!clip_rect(&srcX, &srcY, &width, &height, &skipX, &skipY)) return;
+    x += skipX;
+    y += skipY;
+
+    uint64_t bytes = width * bytes_per_pixel;
+    int64_t pitch = VBE_mode_info->pitch;
+    if (y > srcY) {
+        for (int64_t i = height - 1; i >= 0; i--)
+            memmove(pixel_address(x, y) + i * pitch, pixel_address(srcX, srcY) + i * pitch, bytes);
+    } else {
+        for (int64_t i = 0; i < height; i++)
+            memmove(pixel_address(x, y) + i * pitch, pixel_address(srcX, srcY) + i * pitch, bytes);
+    }
+}
+
+#define OUT_LEFT 1
+#define OUT_RIGHT 2
+#define OUT_TOP 4
+#define OUT_BOTTOM 8
+
+/**
+ * Tells on which sides of the screen a point lies
+ */
+static int out_code(int64_t x, int64_t y) {
+    int code = 0;
+    if (x < 0) code |= OUT_LEFT;
+    else if (x >= VBE_mode_info->width) code |= OUT_RIGHT;
+    if (y < 0) code |= OUT_TOP;
+    else if (y >= VBE_mode_info->height) code |= OUT_BOTTOM;
+    return code;
+}
+
+/**
+ * Clips a line to the screen (Cohen-Sutherland). Returns 0 if it is
+ * entirely outside
+ */
+static int clip_line(int64_t *x0, int64_t *y0, int64_t *x1, int64_t *y1) {
+    int64_t right = VBE_mode_info->width - 1, bottom = VBE_mode_info->height - 1;
+    int code0 = out_code(*x0, *y0), code1 = out_code(*x1, *y1);
+
+    while (code0 | code1) {
+        if (code0 & code1) return 0;
+
+        int code = code0 ? code0 : code1;
+        int64_t x, y;
+        if (code & OUT_TOP) {
+            x = *x0 + (*x1 - *x0) * (0 - *y0) / (*y1 - *y0);
+            y = 0;
+        } else if (code & OUT_BOTTOM) {
+            x = *x0 + (*x1 - *x0) * (bottom - *y0) / (*y1 - *y0);
+            y = bottom;
+        } else if (code & OUT_LEFT) {
+            y = *y0 + (*y1 - *y0) * (0 - *x0) / (*x1 - *x0);
+            x = 0;
+        } else {
+            y = *y0 + (*y1 - *y0) * (right - *x0) / (*x1 - *x0);
+            x = right;
+        }
+
+        if (code == code0) {
+            *x0 = x;
+            *y0 = y;
+            code0 = out_code(x, y);
+        } else {
+            *x1 = x;
+            *y1 = y;
+            code1 = out_code(x, y);
+        }
+    }
+    return 1;
+}
+
+/**
+ * Draws a line (Bresenham) clipped to the screen. Horizontal and vertical
+ * lines are drawn as rectangles
+ */
+static void draw_line(uint32_t hexColor, int64_t x0, int64_t y0, int64_t x1, int64_t y1) {
+    if (y0 == y1 || x0 == x1) {
+        int64_t x = x0 < x1 ? x0 : x1, y = y0 < y1 ? y0 : y1;
+        fill_rect(hexColor, x, y, (x0 < x1 ? x1 - x0 : x0 - x1) + 1, (y0 < y1 ? y1 - y0 : y0 - y1) + 1);
+        return;
+    }
+    if (!clip_line(&x0, &y0, &x1, &y1)) return;
+
+    int64_t dx = x1 > x0 ? x1 - x0 : x0 - x1, stepX = x1 > x0 ? 1 : -1;
+    int64_t dy = y1 > y0 ? y0 - y1 : y1 - y0, stepY = y1 > y0 ? 1 : -1;
+    int64_t error = dx + dy;
+    uint32_t native = native_color(hexColor);
+
+    // Both ends are on screen now, so every point in between is too
+    while (1) {
+        pixel_routines.store_pixel(pixel_address(x0, y0), native);
+        if (x0 == x1 && y0 == y1) break;
+        int64_t doubled = 2 * error;
+        if (doubled >= dy) {
+            error += dy;
+            x0 += stepX;
+        }
+        if (doubled <= dx) {
+            error += dx;
+            y0 += stepY;
+        }
+    }
+}
+
+/**
+ * Draws a character scaled by scale. Each run of set bits in a font row is
+ * filled as a single rectangle
+ */
+static void draw_glyph(char c, uint32_t hexColor, int64_t posX, int64_t posY, uint32_t scale) {
+    const uint8_t *glyph = FONT[(unsigned char)c];
+    uint32_t native = native_color(hexColor);
+
+    for (uint32_t y = 0; y < CHAR_BIT_HEIGHT; y++) {
+        uint32_t x = 0;
+        while (x < CHAR_BIT_WIDTH) {
+            // Bit 0 is the leftmost pixel
+            if (!(glyph[y] & (1 << x))) {
+                x++;
+                continue;
+            }
+            uint32_t start = x;
+            while (x < CHAR_BIT_WIDTH && (glyph[y] & (1 << x))) x++;
+            fill_native(native, posX + start * scale, posY + y * scale, (x - start) * scale, scale);
+        }
+    }
+}
 
 //=============================================================================
 // BASIC DRAWING FUNCTIONS
@@ -74,23 +488,14 @@ static uint32_t font_size = 1;
 void put_pixel(uint32_t hexColor, uint64_t x, uint64_t y) {
     if (x >= VBE_mode_info->width || y >= VBE_mode_info->height) return;
 
-    uint64_t offset = (x * (VBE_mode_info->bpp / 8)) + (y * VBE_mode_info->pitch);
-    uint8_t* framebuffer = (uint8_t*)VBE_mode_info->framebuffer;
-    
-    framebuffer[offset]     = (hexColor) & 0xFF;         // Blue
-    framebuffer[offset+1]   = (hexColor >> 8) & 0xFF;    // Green
-    framebuffer[offset+2]   = (hexColor >> 16) & 0xFF;   // Red
+    pixel_routines.store_pixel(pixel_address(x, y), native_color(hexColor));
 }
 
 /**
  * Draws a rectangle with specified color and dimensions
  */
 void draw_rect(uint32_t hexColor, uint32_t posX, uint32_t posY, uint32_t width, uint32_t height) {
-    for (uint32_t y = posY; y < posY + height && y < VBE_mode_info->height; y++) {
-        for (uint32_t x = posX; x < posX + width && x < VBE_mode_info->width; x++) {
-            put_pixel(hexColor, x, y);
-        }
-    }
+    fill_rect(hexColor, posX, posY, width, height);
 }
 
 /**
@@ -115,14 +520,14 @@ void clear_screen(uint32_t clearColor) {
  * Gets current font width in pixels
  */
 uint32_t get_font_width() {
-    return font_size * CHAR_BIT_WIDTH;
+    return active->font_size * CHAR_BIT_WIDTH;
 }
 
 /**
  * Gets current font height in pixels
  */
 uint32_t get_font_height() {
-    return font_size * CHAR_BIT_HEIGHT;
+    return active->font_size * CHAR_BIT_HEIGHT;
 }
 
 /**
@@ -133,18 +538,10 @@ uint32_t get_chars_per_line() {
 }
 
 /**
- * Draws a single character at the specified position (FIXED - LSB to MSB reading)
+ * Draws a single character at the specified position
  */
 void draw_char(char c, uint32_t hexColor, uint32_t posX, uint32_t posY) {
-    for (uint32_t y = 0; y < CHAR_BIT_HEIGHT; y++) {
-        for (uint32_t x = 0; x < CHAR_BIT_WIDTH; x++) {
-            // FIXED: Read bit from LSB to MSB (bit 0 is leftmost pixel)
-            uint8_t bit = FONT[(unsigned char)c][y] & (1 << x);
-            if (bit) {
-                draw_square(hexColor, posX + x * font_size, posY + y * font_size, font_size);
-            }
-        }
-    }
+    draw_glyph(c, hexColor, posX, posY, active->font_size);
 }
 
 /**
@@ -162,140 +559,568 @@ void draw_string(const char* str, uint32_t len, uint32_t hexColor, uint32_t posX
 //=============================================================================
 
 /**
- * Re-renders all text from the buffer to the screen
+ * Gets how many characters of a console fit per screen line
  */
-static void render_text_buffer() {
-    clear_screen(0x000000);
-    
-    uint32_t font_width = get_font_width();
-    uint32_t font_height = get_font_height();
-    uint32_t chars_per_line = get_chars_per_line();
-    uint32_t lines_per_screen = VBE_mode_info->height / font_height;
-    
-    // Determine which lines to show (scroll if necessary)
-    uint32_t start_line = 0;
-    if (cursor_y >= lines_per_screen) {
-        start_line = cursor_y - lines_per_screen + 1;
+static uint32_t console_chars_per_line(console_t *console) {
+    uint32_t chars_per_line = VBE_mode_info->width / (console->font_size * CHAR_BIT_WIDTH);
+    return chars_per_line < SCREEN_TEXT_BUFFER_WIDTH ? chars_per_line : SCREEN_TEXT_BUFFER_WIDTH;
+}
+
+/**
+ * Gets how many text lines of a console fit on screen
+ */
+static uint32_t console_lines_per_screen(console_t *console) {
+    return VBE_mode_info->height / (console->font_size * CHAR_BIT_HEIGHT);
+}
+
+/**
+ * Gets how many lines the history holds
+ */
+static uint64_t history_capacity(console_t *console) {
+    return console->history_lines != 0 ? console->history_lines : SCREEN_TEXT_BUFFER_HEIGHT;
+}
+
+/**
+ * Gets the cells of a text line inside the history ring
+ */
+static TextLine *text_line(console_t *console, uint64_t line) {
+    if (console->history_lines == 0) return &boot_history[line % SCREEN_TEXT_BUFFER_HEIGHT];
+
+    uint64_t slot = line % console->history_lines;
+    return console->history_blocks[slot / LINES_PER_BLOCK] + slot % LINES_PER_BLOCK;
+}
+
+/**
+ * Gets the palette index of a color, adding it if there is room. With a
+ * full palette the closest color is used
+ */
+static uint8_t palette_index(uint32_t hexColor) {
+    if (palette[last_color] == hexColor) return last_color;
+
+    uint32_t best = 0, best_distance = 0xFFFFFFFF;
+    for (uint32_t i = 0; i < palette_count; i++) {
+        int32_t red = (int32_t)(palette[i] >> 16 & 0xFF) - (int32_t)(hexColor >> 16 & 0xFF);
+        int32_t green = (int32_t)(palette[i] >> 8 & 0xFF) - (int32_t)(hexColor >> 8 & 0xFF);
+        int32_t blue = (int32_t)(palette[i] & 0xFF) - (int32_t)(hexColor & 0xFF);
+        uint32_t distance = red * red + green * green + blue * blue;
+        if (distance < best_distance) {
+            best = i;
+            best_distance = distance;
+        }
     }
-    
-    // Render visible text
-    for (uint32_t y = start_line; y < start_line + lines_per_screen && y < SCREEN_TEXT_BUFFER_HEIGHT; y++) {
-        for (uint32_t x = 0; x < chars_per_line && x < SCREEN_TEXT_BUFFER_WIDTH; x++) {
-            if (text_buffer[y][x].c != ' ') {
-                draw_char(text_buffer[y][x].c, text_buffer[y][x].color, 
-                         x * font_width, (y - start_line) * font_height);
-            }
+
+    if (best_distance != 0 && palette_count < PALETTE_SIZE) {
+        best = palette_count++;
+        palette[best] = hexColor;
+    }
+    last_color = best;
+    return best;
+}
+
+/**
+ * Gets the oldest line still in the history
+ */
+static uint64_t oldest_line(console_t *console) {
+    uint64_t capacity = history_capacity(console);
+    return console->last_line >= console->first_line + capacity ? console->last_line - capacity + 1 : console->first_line;
+}
+
+/**
+ * Fills a text line with blanks
+ */
+static void clear_text_line(TextLine *line) {
+    memset(line->glyphs, ' ', SCREEN_TEXT_BUFFER_WIDTH);
+    memset(line->colors, 0, SCREEN_TEXT_BUFFER_WIDTH);
+}
+
+/**
+ * Gives each console its history frames, an equal part of a share of the
+ * free memory. Console 0 moves its text over from boot_history, unless its
+ * part is not bigger; a console left without frames cannot be used
+ */
+static void init_history() {
+    uint64_t blocks = pmm_free_frame_count() / HISTORY_MEMORY_SHARE / MAX_CONSOLES;
+    if (blocks > MAX_HISTORY_BLOCKS) blocks = MAX_HISTORY_BLOCKS;
+
+    for (uint32_t i = 0; i < MAX_CONSOLES; i++) {
+        console_t *console = &consoles[i];
+        uint64_t allocated = 0;
+        while (allocated < blocks) {
+            uint64_t frame = pmm_alloc_frame();
+            if (frame == 0) break;
+            console->history_blocks[allocated++] = (TextLine*)P2V(frame);
+        }
+
+        if (allocated * LINES_PER_BLOCK <= SCREEN_TEXT_BUFFER_HEIGHT) {
+            for (uint64_t j = 0; j < allocated; j++) pmm_free_frame(V2P(console->history_blocks[j]));
+            continue;
+        }
+
+        // Lines boot_history already dropped are not in the bigger ring either
+        console->first_line = oldest_line(console);
+        console->history_lines = allocated * LINES_PER_BLOCK;
+        for (uint64_t line = console->first_line; line <= console->last_line; line++) {
+            *text_line(console, line) = boot_history[line % SCREEN_TEXT_BUFFER_HEIGHT];
         }
     }
 }
 
 /**
- * Scrolls the text buffer up by one line
+ * Tells whether a console has somewhere to keep its text. Only console 0
+ * may use boot_history
  */
-static void scroll_text_buffer() {
-    // Move all lines up
-    for (uint32_t y = 0; y < SCREEN_TEXT_BUFFER_HEIGHT - 1; y++) {
-        for (uint32_t x = 0; x < SCREEN_TEXT_BUFFER_WIDTH; x++) {
-            text_buffer[y][x] = text_buffer[y + 1][x];
+int console_available(uint32_t index) {
+    return index < MAX_CONSOLES && (index == 0 || consoles[index].history_lines != 0);
+}
+
+/**
+ * Gets the first text line shown: the one that leaves the cursor line at
+ * the bottom, or the one chosen with scroll_text_view
+ */
+static uint64_t first_visible_line(console_t *console) {
+    uint64_t lines_per_screen = console_lines_per_screen(console);
+    uint64_t bottom = console->cursor_line >= lines_per_screen ? console->cursor_line - lines_per_screen + 1 : 0;
+    if (console->following || console->view_line >= bottom) return bottom;
+
+    uint64_t oldest = oldest_line(console);
+    return console->view_line > oldest ? console->view_line : oldest;
+}
+
+/**
+ * Draws the characters of one text line at the given screen row
+ */
+static void draw_text_line(console_t *console, uint64_t line, uint32_t posY) {
+    if (line < oldest_line(console) || line > console->last_line) return;
+
+    TextLine *cells = text_line(console, line);
+    uint32_t font_width = console->font_size * CHAR_BIT_WIDTH;
+    uint32_t chars_per_line = console_chars_per_line(console);
+
+    for (uint32_t x = 0; x < chars_per_line; x++) {
+        if (cells->glyphs[x] != ' ') {
+            draw_glyph(cells->glyphs[x], palette[cells->colors[x]], x * font_width, posY, console->font_size);
         }
     }
+}
+
+/**
+ * Re-renders the visible lines of the history to the screen
+ */
+static void render_text_buffer(console_t *console) {
+    clear_screen(0x000000);
     
-    // Clear last line
-    for (uint32_t x = 0; x < SCREEN_TEXT_BUFFER_WIDTH; x++) {
-        text_buffer[SCREEN_TEXT_BUFFER_HEIGHT - 1][x].c = ' ';
-        text_buffer[SCREEN_TEXT_BUFFER_HEIGHT - 1][x].color = 0xFFFFFF;
-    }
+    uint32_t font_height = console->font_size * CHAR_BIT_HEIGHT;
+    uint32_t lines_per_screen = console_lines_per_screen(console);
     
-    cursor_y--;
+    // Only the lines on screen are drawn, however long the history is
+    uint64_t start_line = first_visible_line(console);
+    for (uint64_t y = start_line; y < start_line + lines_per_screen; y++) {
+        draw_text_line(console, y, (y - start_line) * font_height);
+    }
+
+    console->shown_line = start_line;
+    console->dirty = 0;
 }
 
 /**
- * Writes text to screen at current cursor position
+ * Remembers that a text line has to be redrawn
  */
-void write_to_video_text_buffer(const char* data, uint32_t data_len, uint32_t hexColor) {
-    uint32_t chars_per_line = get_chars_per_line();
-    if (chars_per_line > SCREEN_TEXT_BUFFER_WIDTH) {
-        chars_per_line = SCREEN_TEXT_BUFFER_WIDTH;
+static void mark_dirty(console_t *console, uint64_t line) {
+    if (!console->dirty || line < console->dirty_from) console->dirty_from = line;
+    if (!console->dirty || line > console->dirty_to) console->dirty_to = line;
+    console->dirty = 1;
+}
+
+/**
+ * Brings the screen up to date with the text buffer of the active console.
+ * When the text scrolls down and the video memory below the screen has
+ * room, the screen is panned (hardware scroll) and only the new lines are
+ * drawn. Otherwise panning starts over from the top of video memory with a
+ * full redraw. Changed lines that are not on screen are not drawn at all
+ */
+static void update_text_buffer(console_t *console) {
+    uint32_t font_height = console->font_size * CHAR_BIT_HEIGHT;
+    uint32_t lines_per_screen = console_lines_per_screen(console);
+    uint64_t start_line = first_visible_line(console);
+    uint64_t shown_line = console->shown_line;
+
+    if (start_line != shown_line) {
+        if (start_line < shown_line || screen_top + (start_line - shown_line) * font_height + VBE_mode_info->height > virtual_height) {
+            screen_top = 0;
+            bga_set_y_offset(0);
+            render_text_buffer(console);
+            return;
+        }
+        // New lines are drawn before the screen moves to show them
+        screen_top += (start_line - shown_line) * font_height;
+        if (start_line - shown_line < lines_per_screen) {
+            mark_dirty(console, shown_line + lines_per_screen);
+        } else {
+            mark_dirty(console, start_line);
+        }
+        mark_dirty(console, start_line + lines_per_screen - 1);
+        console->shown_line = start_line;
+        draw_rect(0x000000, 0, lines_per_screen * font_height, VBE_mode_info->width, VBE_mode_info->height - lines_per_screen * font_height);
     }
-    
+
+    if (console->dirty) {
+        uint64_t from = console->dirty_from > start_line ? console->dirty_from : start_line;
+        for (uint64_t y = from; y <= console->dirty_to && y < start_line + lines_per_screen; y++) {
+            draw_rect(0x000000, 0, (y - start_line) * font_height, VBE_mode_info->width, font_height);
+            draw_text_line(console, y, (y - start_line) * font_height);
+        }
+        console->dirty = 0;
+    }
+    bga_set_y_offset(screen_top);
+}
+
+/**
+ * Moves the cursor to the start of the next line. A line reached for the
+ * first time takes the slot of the oldest one in the history
+ */
+static void new_line(console_t *console) {
+    console->cursor_x = 0;
+    console->cursor_line++;
+    if (console->cursor_line > console->last_line) {
+        console->last_line = console->cursor_line;
+        clear_text_line(text_line(console, console->last_line));
+    }
+}
+
+/**
+ * Writes text to a console at its cursor position. Only the active
+ * console reaches the screen; the others just remember what changed
+ */
+void write_to_console(uint32_t index, const char* data, uint32_t data_len, uint32_t hexColor) {
+    if (!console_available(index)) return;
+
+    console_t *console = &consoles[index];
+    uint32_t chars_per_line = console_chars_per_line(console);
+    uint8_t color = palette_index(hexColor);
+    mark_dirty(console, console->cursor_line);
     for (uint32_t i = 0; i < data_len; i++) {
         switch (data[i]) {
             case '\n':  // New line
-                cursor_x = 0;
-                cursor_y++;
+                new_line(console);
                 break;
                 
             case '\r':  // Carriage return
-                cursor_x = 0;
+                console->cursor_x = 0;
                 break;
                 
             case '\t':  // Tab (4 spaces)
-                cursor_x = (cursor_x + 4) & ~3;  // Align to next multiple of 4
-                if (cursor_x >= chars_per_line) {
-                    cursor_x = 0;
-                    cursor_y++;
+                console->cursor_x = (console->cursor_x + 4) & ~3;  // Align to next multiple of 4
+                if (console->cursor_x >= chars_per_line) {
+                    new_line(console);
                 }
                 break;
                 
             case '\b':  // Backspace
-                if (cursor_x > 0) {
-                    cursor_x--;
-                    text_buffer[cursor_y][cursor_x].c = ' ';
-                    text_buffer[cursor_y][cursor_x].color = hexColor;
-                } else if (cursor_y > 0) {
-                    cursor_y--;
-                    cursor_x = chars_per_line - 1;
-                    text_buffer[cursor_y][cursor_x].c = ' ';
-                    text_buffer[cursor_y][cursor_x].color = hexColor;
+                if (console->cursor_x > 0) {
+                    console->cursor_x--;
+                    text_line(console, console->cursor_line)->glyphs[console->cursor_x] = ' ';
+                    text_line(console, console->cursor_line)->colors[console->cursor_x] = color;
+                } else if (console->cursor_line > oldest_line(console)) {
+                    console->cursor_line--;
+                    console->cursor_x = chars_per_line - 1;
+                    text_line(console, console->cursor_line)->glyphs[console->cursor_x] = ' ';
+                    text_line(console, console->cursor_line)->colors[console->cursor_x] = color;
                 }
                 break;
                 
             default:    // Regular character
-                if (cursor_x >= chars_per_line) {
-                    cursor_x = 0;
-                    cursor_y++;
-                }
-                
-                // Check if we need to scroll
-                if (cursor_y >= SCREEN_TEXT_BUFFER_HEIGHT) {
-                    scroll_text_buffer();
+                if (console->cursor_x >= chars_per_line) {
+                    new_line(console);
                 }
                 
                 // Add character to buffer
-                text_buffer[cursor_y][cursor_x].c = data[i];
-                text_buffer[cursor_y][cursor_x].color = hexColor;
-                cursor_x++;
+                text_line(console, console->cursor_line)->glyphs[console->cursor_x] = data[i];
+                text_line(console, console->cursor_line)->colors[console->cursor_x] = color;
+                console->cursor_x++;
                 break;
         }
+        mark_dirty(console, console->cursor_line);
     }
     
-    render_text_buffer();
+    if (console == active) update_text_buffer(console);
+}
+
+/**
+ * Writes text to the active console at its cursor position
+ */
+void write_to_video_text_buffer(const char* data, uint32_t data_len, uint32_t hexColor) {
+    write_to_console(active - consoles, data, data_len, hexColor);
 }
 
 /**
- * Clears the text buffer and resets cursor
+ * Clears the text buffer of the active console and resets its cursor
  */
 void clear_video_text_buffer() {
-    cursor_x = 0;
-    cursor_y = 0;
+    active->cursor_x = 0;
+    active->cursor_line = 0;
+    active->first_line = 0;
+    active->last_line = 0;
+    active->following = 1;
     
-    // Clear text buffer
-    for (uint32_t y = 0; y < SCREEN_TEXT_BUFFER_HEIGHT; y++) {
-        for (uint32_t x = 0; x < SCREEN_TEXT_BUFFER_WIDTH; x++) {
-            text_buffer[y][x].c = ' ';
-            text_buffer[y][x].color = 0xFFFFFF;
-        }
-    }
+    // The other lines are cleared when the cursor reaches them
+    clear_text_line(text_line(active, 0));
     
+    active->shown_line = 0;
+    active->dirty = 0;
+    screen_top = 0;
+    bga_set_y_offset(0);
     clear_screen(0x000000);
 }
 
 /**
- * Sets the font size (1-5) and re-renders all text
+ * Pages the view of the active console through its history, a screen at a time
+ */
+void scroll_text_view(int32_t pages) {
+    uint64_t lines_per_screen = console_lines_per_screen(active);
+    uint64_t bottom = active->cursor_line >= lines_per_screen ? active->cursor_line - lines_per_screen + 1 : 0;
+    int64_t target = (int64_t)first_visible_line(active) + (int64_t)pages * (int64_t)lines_per_screen;
+
+    if (target < (int64_t)oldest_line(active)) target = oldest_line(active);
+    active->following = target >= (int64_t)bottom;
+    active->view_line = active->following ? bottom : (uint64_t)target;
+    update_text_buffer(active);
+}
+
+/**
+ * Sets the font size (1-5) of the active console and re-renders all text
  */
 void set_font_size(uint32_t fontSize) {
     if (fontSize > 0 && fontSize <= 5) {
-        font_size = fontSize;
-        render_text_buffer();  // Re-render with new font size
+        active->font_size = fontSize;
+        render_text_buffer(active);  // Re-render with new font size
     }
-}
\ No newline at end of file
+}
+
+//=============================================================================
+// CONSOLE SWITCHING
+//=============================================================================
+
+/**
+ * Makes sure the cache of a console has frames for a whole screen
+ */
+static int reserve_cache(console_t *console, uint64_t size) {
+    uint64_t pages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+    if (pages > MAX_CACHE_PAGES) return 0;
+
+    while (console->cache_pages < pages) {
+        uint64_t frame = pmm_alloc_frame();
+        if (frame == 0) return 0;
+        console->cache[console->cache_pages++] = (uint8_t*)P2V(frame);
+    }
+    return 1;
+}
+
+/**
+ * Copies the visible part of video memory to the cache of a console, or
+ * the cache back to the screen
+ */
+static void copy_screen_cache(console_t *console, uint64_t size, int restore) {
+    uint8_t *screen = pixel_address(0, 0);
+    for (uint64_t offset = 0; offset < size; offset += PAGE_SIZE) {
+        uint64_t length = size - offset < PAGE_SIZE ? size - offset : PAGE_SIZE;
+        if (restore) {
+            memcpy(screen + offset, console->cache[offset / PAGE_SIZE], length);
+        } else {
+            memcpy(console->cache[offset / PAGE_SIZE], screen + offset, length);
+        }
+    }
+}
+
+/**
+ * Forgets the screens kept for the hidden consoles (the mode changed)
+ */
+static void invalidate_console_caches() {
+    for (uint32_t i = 0; i < MAX_CONSOLES; i++) consoles[i].cached = 0;
+}
+
+/**
+ * Shows another console. The screen of the one being hidden is kept in its
+ * cache; the new one is restored from its cache and only the lines written
+ * while it was hidden are drawn. A console without a usable cache, or one
+ * whose view moved a screen or more, is rendered in full
+ */
+int switch_console(uint32_t index) {
+    if (!console_available(index)) return -1;
+
+    console_t *console = &consoles[index];
+    if (console == active) return 0;
+
+    uint64_t size = (uint64_t)VBE_mode_info->pitch * VBE_mode_info->height;
+    active->cached = reserve_cache(active, size);
+    if (active->cached) copy_screen_cache(active, size, 0);
+
+    // Panning starts over from the top of video memory. Lines the view
+    // moved down while hidden are panned in like any other scroll
+    active = console;
+    screen_top = 0;
+    uint64_t start_line = first_visible_line(console);
+    if (console->cached && start_line >= console->shown_line && start_line - console->shown_line < console_lines_per_screen(console)) {
+        copy_screen_cache(console, size, 1);
+        update_text_buffer(console);
+    } else {
+        bga_set_y_offset(0);
+        render_text_buffer(console);
+    }
+    console->cached = 0;
+    return 0;
+}
+
+/**
+ * Gets the index of the console on screen
+ */
+uint32_t active_console() {
+    return active - consoles;
+}
+
+//=============================================================================
+// DIRECT FRAMEBUFFER ACCESS
+//=============================================================================
+
+/**
+ * Converts a VBE mask size and position into a bit mask
+ */
+static uint32_t color_mask(uint8_t size, uint8_t position) {
+    return size >= 32 ? 0xFFFFFFFF : ((1U << size) - 1) << position;
+}
+
+/**
+ * Gets how many screens fit in video memory
+ */
+static uint32_t framebuffer_pages() {
+    uint32_t pages = virtual_height / VBE_mode_info->height;
+    return pages > 0 ? pages : 1;
+}
+
+/**
+ * Fills the framebuffer geometry from the VBE mode information
+ */
+void get_framebuffer_info(framebuffer_info_t *info) {
+    info->address = VBE_mode_info->framebuffer;
+    info->width = VBE_mode_info->width;
+    info->height = VBE_mode_info->height;
+    info->pitch = VBE_mode_info->pitch;
+    info->bpp = VBE_mode_info->bpp;
+    info->red_mask = color_mask(VBE_mode_info->red_mask, VBE_mode_info->red_position);
+    info->green_mask = color_mask(VBE_mode_info->green_mask, VBE_mode_info->green_position);
+    info->blue_mask = color_mask(VBE_mode_info->blue_mask, VBE_mode_info->blue_position);
+    info->pages = framebuffer_pages();
+}
+
+/**
+ * Copies a back buffer with the framebuffer layout to the screen
+ */
+void present_framebuffer(const uint8_t *buffer) {
+    memcpy(pixel_address(0, 0), buffer, (uint64_t)VBE_mode_info->pitch * VBE_mode_info->height);
+}
+
+/**
+ * Pans the screen to one of the pages of video memory
+ */
+int show_framebuffer_page(uint32_t page) {
+    if (page >= framebuffer_pages()) return -1;
+
+    screen_top = page * VBE_mode_info->height;
+    bga_set_y_offset(screen_top);
+    return 0;
+}
+
+//=============================================================================
+// VIDEO MODE
+//=============================================================================
+
+/**
+ * Reads the pitch and virtual height the adapter is using
+ */
+static void load_geometry() {
+    uint32_t pitch;
+    bga_get_geometry(&pitch, &virtual_height);
+    VBE_mode_info->pitch = pitch;
+    if (virtual_height < VBE_mode_info->height) virtual_height = VBE_mode_info->height;
+}
+
+/**
+ * Detects the Bochs VBE extensions to pan the screen over video memory
+ */
+void video_init() {
+    select_pixel_format();
+    init_history();
+    virtual_height = VBE_mode_info->height;
+    if (bga_init() != 0) return;
+
+    load_geometry();
+    screen_top = 0;
+}
+
+/**
+ * Switches the resolution and depth at runtime and redraws the text
+ */
+int set_video_mode(uint32_t width, uint32_t height, uint32_t bpp) {
+    if ((bpp != 15 && bpp != 16 && bpp != 24 && bpp != 32) || width == 0 || height == 0 || width > 0xFFFF || height > 0xFFFF) return -1;
+    if (bga_set_mode(width, height, bpp) != 0) return -1;
+
+    // The rest of the driver reads the mode from here. Bochs uses
+    // x1r5g5b5, r5g6b5, r8g8b8 and x8r8g8b8
+    VBE_mode_info->width = width;
+    VBE_mode_info->height = height;
+    VBE_mode_info->bpp = bpp;
+    VBE_mode_info->red_mask = bpp == 15 || bpp == 16 ? 5 : 8;
+    VBE_mode_info->green_mask = bpp == 15 ? 5 : bpp == 16 ? 6 : 8;
+    VBE_mode_info->blue_mask = bpp == 15 || bpp == 16 ? 5 : 8;
+    VBE_mode_info->red_position = bpp == 15 ? 10 : bpp == 16 ? 11 : 16;
+    VBE_mode_info->green_position = bpp == 15 || bpp == 16 ? 5 : 8;
+    VBE_mode_info->blue_position = 0;
+    select_pixel_format();
+    load_geometry();
+
+    screen_top = 0;
+    invalidate_console_caches();
+    render_text_buffer(active);
+    return 0;
+}
+
+//=============================================================================
+// GRAPHICS COMMANDS
+//=============================================================================
+
+/**
+ * Runs one graphics command. Returns 0 if its type is unknown
+ */
+static int execute_gfx_command(const gfx_command_t *command) {
+    switch (command->type) {
+        case GFX_FILL_RECT:
+            fill_rect(command->color, command->x, command->y, command->width, command->height);
+            return 1;
+        case GFX_BLIT:
+            blit_bitmap(command->args.blit.pixels, command->args.blit.stride, command->x, command->y, command->width, command->height);
+            return 1;
+        case GFX_GLYPHS: {
+            uint32_t scale = command->args.glyphs.scale != 0 ? command->args.glyphs.scale : active->font_size;
+            for (uint32_t i = 0; i < command->args.glyphs.length; i++)
+                draw_glyph(command->args.glyphs.text[i], command->color, command->x + (int64_t)i * CHAR_BIT_WIDTH * scale, command->y, scale);
+            return 1;
+        }
+        case GFX_LINE:
+            draw_line(command->color, command->x, command->y, command->args.line.x2, command->args.line.y2);
+            return 1;
+        case GFX_COPY_RECT:
+            copy_rect(command->args.copy.src_x, command->args.copy.src_y, command->x, command->y, command->width, command->height);
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Runs a batch of graphics commands in order
+ */
+uint64_t execute_gfx_commands(const gfx_command_t *commands, uint64_t count) {
+    uint64_t done = 0;
+    while (done < count && execute_gfx_command(&commands[done]))
+        done++;
+    return done;
+}
@@ -0,0 +1,203 @@
+#include <stdint.h>
+#include <blockCache.h>
+#include <ataDriver.h>
+#include <diskQueue.h>
+#include <scheduler.h>
+#include <pmm.h>
+
+#define CACHE_BUCKETS 128
+#define NONE -1
+#define INVALID_BLOCK ((uint64_t)-1)
+
+/*
+ * Las entradas se buscan por un hash del numero de bloque y se mantienen en
+ * una lista doblemente enlazada por uso: la cabeza es la mas reciente y la
+ * cola la proxima en desalojarse. Los frames se piden al PMM a medida que
+ * hacen falta.
+ */
+typedef struct {
+	uint64_t block;
+	uint64_t frame;                 // 0 si la entrada nunca se uso
+	int hash_next;
+	int lru_prev;
+	int lru_next;
+} cache_entry_t;
+
+static cache_entry_t entries[CACHE_BLOCKS];
+static int buckets[CACHE_BUCKETS];
+static int lru_head = NONE;
+static int lru_tail = NONE;
+static int used_entries = 0;
+static uint64_t hits, misses;
+
+// Una lectura puede bloquear al proceso: el cache se usa de a uno
+static int busy = 0;
+static wait_queue_t busy_waiters;
+
+static int hash(uint64_t block) {
+	return block % CACHE_BUCKETS;
+}
+
+static void lru_remove(int index) {
+	cache_entry_t *entry = &entries[index];
+
+	if (entry->lru_prev != NONE)
+		entries[entry->lru_prev].lru_next = entry->lru_next;
+	else
+		lru_head = entry->lru_next;
+
+	if (entry->lru_next != NONE)
+		entries[entry->lru_next].lru_prev = entry->lru_prev;
+	else
+		lru_tail = entry->lru_prev;
+}
+
+static void lru_push_front(int index) {
+	entries[index].lru_prev = NONE;
+	entries[index].lru_next = lru_head;
+	if (lru_head != NONE)
+		entries[lru_head].lru_prev = index;
+	lru_head = index;
+	if (lru_tail == NONE)
+		lru_tail = index;
+}
+
+static void hash_remove(int index) {
+	int *link = &buckets[hash(entries[index].block)];
+
+	while (*link != index)
+		link = &entries[*link].hash_next;
+	*link = entries[index].hash_next;
+}
+
+static void hash_insert(int index, uint64_t block) {
+	entries[index].block = block;
+	entries[index].hash_next = buckets[hash(block)];
+	buckets[hash(block)] = index;
+}
+
+// La entrada sigue en las listas pero ningun bloque la encuentra
+static void invalidate(int index) {
+	hash_remove(index);
+	hash_insert(index, INVALID_BLOCK);
+}
+
+static int lookup(uint64_t block) {
+	for (int index = buckets[hash(block)]; index != NONE; index = entries[index].hash_next)
+		if (entries[index].block == block)
+			return index;
+	return NONE;
+}
+
+/*
+ * Entrada para un bloque nuevo, con un frame propio: si el anterior sigue
+ * mapeado en algun proceso, soltar la referencia no lo libera.
+ */
+static int allocate_entry(uint64_t block) {
+	int index;
+
+	if (used_entries < CACHE_BLOCKS) {
+		index = used_entries++;
+	} else {
+		index = lru_tail;
+		lru_remove(index);
+		hash_remove(index);
+		pmm_free_frame(entries[index].frame);
+	}
+
+	entries[index].frame = pmm_alloc_frame();
+	hash_insert(index, entries[index].frame != 0 ? block : INVALID_BLOCK);
+	lru_push_front(index);
+	return entries[index].frame != 0 ? index : NONE;
+}
+
+void cache_init(void) {
+	for (int i = 0; i < CACHE_BUCKETS; i++)
+		buckets[i] = NONE;
+}
+
+static void lock(void) {
+	while (busy)
+		scheduler_wait(&busy_waiters);
+	busy = 1;
+}
+
+static void unlock(void) {
+	busy = 0;
+	scheduler_wake_all(&busy_waiters);
+}
+
+static uint64_t get_block(uint64_t block, uint64_t limit) {
+	int index = lookup(block);
+
+	if (index != NONE) {
+		hits++;
+		lru_remove(index);
+		lru_push_front(index);
+		return entries[index].frame;
+	}
+
+	misses++;
+
+	// El readahead corta en el primer bloque que ya este en memoria
+	uint32_t count = 1;
+	while (count < CACHE_READAHEAD_BLOCKS && block + count < limit && lookup(block + count) == NONE)
+		count++;
+
+	int indexes[CACHE_READAHEAD_BLOCKS];
+	void *pages[CACHE_READAHEAD_BLOCKS];
+	int allocated = 0;
+
+	// Del ultimo al primero, para que el bloque pedido quede como el mas reciente
+	for (int i = count - 1; i >= 0; i--, allocated++) {
+		indexes[i] = allocate_entry(block + i);
+		if (indexes[i] == NONE)
+			break;
+		pages[i] = P2V(entries[indexes[i]].frame);
+	}
+
+	if (allocated < count || disk_read_pages(block * ATA_SECTORS_PER_PAGE, pages, count) != 0) {
+		for (int i = count - allocated; i < count; i++)
+			invalidate(indexes[i]);
+		return 0;
+	}
+
+	return entries[indexes[0]].frame;
+}
+
+uint64_t cache_get_block(uint64_t block, uint64_t limit) {
+	lock();
+	uint64_t frame = get_block(block, limit);
+	unlock();
+	return frame;
+}
+
+uint64_t cache_peek_block(uint64_t block) {
+	// Mientras se llena una entrada ya esta en el hash pero sin los datos
+	if (busy)
+		return 0;
+
+	int index = lookup(block);
+	if (index == NONE)
+		return 0;
+
+	hits++;
+	lru_remove(index);
+	lru_push_front(index);
+	return entries[index].frame;
+}
+
+void cache_invalidate(uint64_t block, uint64_t count) {
+	lock();
+	for (uint64_t i = 0; i < count; i++) {
+		int index = lookup(block + i);
+		if (index != NONE)
+			invalidate(index);
+	}
+	unlock();
+}
+
+void cache_stats(uint64_t *hit_count, uint64_t *miss_count) {
+	*hit_count = hits;
+	*miss_count = misses;
+}
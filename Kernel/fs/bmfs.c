@@ -0,0 +1,91 @@
+#include <stdint.h>
+#include <bmfs.h>
+#include <blockCache.h>
+#include <pmm.h>
+#include <lib.h>
+
+#define BMFS_MARKER_OFFSET 1024
+#define BMFS_DIRECTORY_BLOCK 1              // bytes 4096 a 8191 del disco
+#define BLOCKS_PER_BMFS_BLOCK (BMFS_BLOCK_SIZE / CACHE_BLOCK_SIZE)
+
+#define NAME_END 0x00
+#define NAME_UNUSED 0x01
+
+// Copia propia: el directorio no cambia (solo lectura) y no se desaloja
+static bmfs_entry_t directory[BMFS_MAX_FILES];
+static int mounted = 0;
+
+int bmfs_init(void) {
+	uint64_t marker = cache_get_block(0, 1);
+	uint64_t frame = cache_get_block(BMFS_DIRECTORY_BLOCK, BMFS_DIRECTORY_BLOCK + 1);
+
+	if (marker == 0 || frame == 0 || memcmp((uint8_t *)P2V(marker) + BMFS_MARKER_OFFSET, "BMFS", 4) != 0)
+		return -1;
+
+	memcpy(directory, P2V(frame), sizeof(directory));
+	mounted = 1;
+	return 0;
+}
+
+const bmfs_entry_t *bmfs_find(const char *name) {
+	if (!mounted)
+		return 0;
+
+	for (int i = 0; i < BMFS_MAX_FILES && directory[i].name[0] != NAME_END; i++) {
+		if (directory[i].name[0] == NAME_UNUSED)
+			continue;
+		// El nombre en disco no siempre termina en 0 si usa los 32 bytes
+		if (strncmp(directory[i].name, name, BMFS_NAME_LENGTH) == 0)
+			return &directory[i];
+	}
+	return 0;
+}
+
+static uint64_t first_block(const bmfs_entry_t *file) {
+	return file->start_block * BLOCKS_PER_BMFS_BLOCK;
+}
+
+// Los archivos son contiguos: el readahead puede llegar hasta el final del archivo
+static uint64_t file_page(const bmfs_entry_t *file, uint64_t offset) {
+	uint64_t end = first_block(file) + (file->size + CACHE_BLOCK_SIZE - 1) / CACHE_BLOCK_SIZE;
+	return cache_get_block(first_block(file) + offset / CACHE_BLOCK_SIZE, end);
+}
+
+int64_t bmfs_read(const bmfs_entry_t *file, uint64_t offset, void *buffer, uint64_t count) {
+	uint8_t *destination = buffer;
+	uint64_t done = 0;
+
+	if (offset >= file->size)
+		return 0;
+	if (count > file->size - offset)
+		count = file->size - offset;
+
+	while (done < count) {
+		uint64_t frame = file_page(file, offset + done);
+		if (frame == 0)
+			return -1;
+
+		uint64_t page_offset = (offset + done) % CACHE_BLOCK_SIZE;
+		uint64_t length = CACHE_BLOCK_SIZE - page_offset;
+		if (length > count - done)
+			length = count - done;
+
+		memcpy(destination + done, (uint8_t *)P2V(frame) + page_offset, length);
+		done += length;
+	}
+	return done;
+}
+
+uint64_t bmfs_page(const bmfs_entry_t *file, uint64_t offset) {
+	uint64_t frame = file_page(file, offset);
+	if (frame != 0)
+		pmm_ref_frame(frame);
+	return frame;
+}
+
+uint64_t bmfs_cached_page(const bmfs_entry_t *file, uint64_t offset) {
+	uint64_t frame = cache_peek_block(first_block(file) + offset / CACHE_BLOCK_SIZE);
+	if (frame != 0)
+		pmm_ref_frame(frame);
+	return frame;
+}
@@ -0,0 +1,222 @@
+#include <stdint.h>
+#include <diskQueue.h>
+#include <ataDriver.h>
+#include <scheduler.h>
+#include <pmm.h>
+#include <lib.h>
+
+#define NONE -1
+#define PAGE_ALIGN_DOWN(x) ((x) & ~(uint64_t)(PAGE_SIZE - 1))
+
+/*
+ * Los pedidos esperan en una cola FIFO. Al arrancar una transferencia se le
+ * suman los pedidos encolados que continuan al ultimo sector (mismo sentido)
+ * mientras entren en una PRD table, y al terminar se completan todos juntos.
+ * Un pedido no se adelanta a otro anterior que toque sus sectores si alguno
+ * de los dos escribe: la lectura traeria (y dejaria en el cache) el dato viejo.
+ * Todo corre con interrupciones deshabilitadas (syscalls o IRQ 14).
+ */
+typedef enum {
+	REQUEST_FREE = 0,
+	REQUEST_QUEUED,
+	REQUEST_ACTIVE,
+	REQUEST_DONE,
+	REQUEST_FAILED
+} request_state_t;
+
+typedef struct {
+	request_state_t state;
+	uint64_t lba;
+	uint32_t sectors;
+	uint8_t write;
+	uint8_t pinned;
+	uint8_t orphan;                         // el dueno termino: se libera al completarse
+	uint64_t owner;
+	dma_segment_t segments[DISK_MAX_REQUEST_SEGMENTS];
+	uint32_t segment_count;
+	int next;                               // siguiente en la cola
+	wait_queue_t waiters;
+} disk_request_t;
+
+static disk_request_t requests[DISK_MAX_REQUESTS];
+static int queue_head = NONE;
+static int queue_tail = NONE;
+
+// Transferencia en curso: los pedidos que la componen
+static int batch[DISK_MAX_REQUESTS];
+static int batch_size = 0;
+static dma_segment_t batch_segments[ATA_MAX_DMA_SEGMENTS];
+
+// Procesos del kernel esperando que se libere un pedido
+static wait_queue_t free_waiters;
+
+static void release(disk_request_t *request) {
+	if (request->pinned)
+		for (uint32_t i = 0; i < request->segment_count; i++)
+			pmm_free_frame(PAGE_ALIGN_DOWN(request->segments[i].address));
+	request->state = REQUEST_FREE;
+	scheduler_wake_all(&free_waiters);
+}
+
+static void finish(int index, int failed) {
+	disk_request_t *request = &requests[index];
+
+	request->state = failed ? REQUEST_FAILED : REQUEST_DONE;
+	if (request->orphan)
+		release(request);
+	else
+		scheduler_wake_all(&request->waiters);
+}
+
+static void dequeue(int index, int previous) {
+	if (previous == NONE)
+		queue_head = requests[index].next;
+	else
+		requests[previous].next = requests[index].next;
+	if (queue_tail == index)
+		queue_tail = previous;
+}
+
+static int conflicts(const disk_request_t *a, const disk_request_t *b) {
+	return (a->write || b->write) && a->lba < b->lba + b->sectors && b->lba < a->lba + a->sectors;
+}
+
+// Busca en la cola un pedido que continue a la transferencia armada
+static int find_merge(uint64_t lba, uint8_t write, uint32_t sectors, uint32_t segments, int *previous) {
+	*previous = NONE;
+	for (int index = queue_head; index != NONE; *previous = index, index = requests[index].next) {
+		disk_request_t *request = &requests[index];
+		if (request->lba != lba || request->write != write
+				|| sectors + request->sectors > ATA_MAX_DMA_SECTORS
+				|| segments + request->segment_count > ATA_MAX_DMA_SEGMENTS)
+			continue;
+
+		for (int other = queue_head; other != index; other = requests[other].next)
+			if (conflicts(&requests[other], request))
+				return NONE;
+		return index;
+	}
+	return NONE;
+}
+
+static void start_next(void) {
+	while (batch_size == 0 && queue_head != NONE) {
+		int index = queue_head, previous;
+		uint64_t lba = requests[index].lba;
+		uint8_t write = requests[index].write;
+		uint32_t sectors = 0, segments = 0;
+
+		dequeue(index, NONE);
+		while (index != NONE) {
+			disk_request_t *request = &requests[index];
+			memcpy(&batch_segments[segments], request->segments, request->segment_count * sizeof(dma_segment_t));
+			segments += request->segment_count;
+			sectors += request->sectors;
+			request->state = REQUEST_ACTIVE;
+			batch[batch_size++] = index;
+
+			index = find_merge(lba + sectors, write, sectors, segments, &previous);
+			if (index != NONE)
+				dequeue(index, previous);
+		}
+
+		if (ata_dma_start(lba, sectors, write, batch_segments, segments) != 0) {
+			for (int i = 0; i < batch_size; i++)
+				finish(batch[i], 1);
+			batch_size = 0;
+		}
+	}
+}
+
+int64_t disk_submit(uint64_t lba, uint32_t sectors, int write, const dma_segment_t *segments, uint32_t count,
+		uint64_t owner, int pinned) {
+	if (!ata_dma_available() || count == 0 || count > DISK_MAX_REQUEST_SEGMENTS)
+		return -1;
+
+	for (int index = 0; index < DISK_MAX_REQUESTS; index++) {
+		disk_request_t *request = &requests[index];
+		if (request->state != REQUEST_FREE)
+			continue;
+
+		request->state = REQUEST_QUEUED;
+		request->lba = lba;
+		request->sectors = sectors;
+		request->write = write != 0;
+		request->pinned = pinned != 0;
+		request->orphan = 0;
+		request->owner = owner;
+		memcpy(request->segments, segments, count * sizeof(dma_segment_t));
+		request->segment_count = count;
+		request->waiters.head = 0;
+
+		request->next = NONE;
+		if (queue_tail != NONE)
+			requests[queue_tail].next = index;
+		else
+			queue_head = index;
+		queue_tail = index;
+
+		start_next();
+		return index;
+	}
+	return -1;
+}
+
+int disk_wait(int64_t id, uint64_t owner) {
+	if (id < 0 || id >= DISK_MAX_REQUESTS)
+		return -1;
+
+	disk_request_t *request = &requests[id];
+	if (request->state == REQUEST_FREE || request->orphan || request->owner != owner)
+		return -1;
+
+	while (request->state == REQUEST_QUEUED || request->state == REQUEST_ACTIVE)
+		scheduler_wait(&request->waiters);
+
+	int result = request->state == REQUEST_DONE ? 0 : -1;
+	release(request);
+	return result;
+}
+
+int disk_read_pages(uint64_t lba, void **pages, uint32_t count) {
+	dma_segment_t segments[DISK_MAX_REQUEST_SEGMENTS];
+
+	if (!ata_dma_available() || count > DISK_MAX_REQUEST_SEGMENTS)
+		return ata_read_pages(lba, pages, count);
+
+	for (uint32_t i = 0; i < count; i++) {
+		segments[i].address = V2P(pages[i]);
+		segments[i].length = PAGE_SIZE;
+	}
+
+	// No se puede caer a PIO con transferencias DMA en curso: se espera lugar
+	int64_t id;
+	while ((id = disk_submit(lba, count * ATA_SECTORS_PER_PAGE, 0, segments, count, 0, 0)) < 0)
+		scheduler_wait(&free_waiters);
+	return disk_wait(id, 0);
+}
+
+void disk_release_owner(uint64_t owner) {
+	for (int index = 0; index < DISK_MAX_REQUESTS; index++) {
+		disk_request_t *request = &requests[index];
+		if (request->state == REQUEST_FREE || request->owner != owner || owner == 0)
+			continue;
+
+		if (request->state == REQUEST_DONE || request->state == REQUEST_FAILED)
+			release(request);
+		else
+			request->orphan = 1;
+	}
+}
+
+void disk_irq_handler(void) {
+	int result = ata_dma_finish();
+	if (result == 1 || batch_size == 0)
+		return;
+
+	for (int i = 0; i < batch_size; i++)
+		finish(batch[i], result != 0);
+	batch_size = 0;
+
+	start_next();
+}
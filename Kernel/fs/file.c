@@ -0,0 +1,213 @@
+#include <stdint.h>
+#include <file.h>
+#include <bmfs.h>
+#include <process.h>
+#include <scheduler.h>
+#include <diskQueue.h>
+#include <blockCache.h>
+#include <ataDriver.h>
+#include <pmm.h>
+#include <mmap.h>
+#include <pipe.h>
+#include <lib.h>
+
+#define SECTORS_PER_BMFS_BLOCK (BMFS_BLOCK_SIZE / ATA_SECTOR_SIZE)
+#define MAX_ASYNC_BYTES ((DISK_MAX_REQUEST_SEGMENTS - 1) * PAGE_SIZE)
+#define SECTOR_ALIGN_UP(x) (((x) + ATA_SECTOR_SIZE - 1) & ~(uint64_t)(ATA_SECTOR_SIZE - 1))
+
+static open_file_t *get_descriptor(uint64_t fd) {
+	if (fd < FIRST_FILE_FD || fd >= FIRST_FILE_FD + MAX_OPEN_FILES)
+		return 0;
+
+	open_file_t *file = &process_current()->files[fd - FIRST_FILE_FD];
+	return file->file != 0 || file->pipe != 0 ? file : 0;
+}
+
+// Solo los descriptores de archivos de BMFS
+static open_file_t *get_file(uint64_t fd) {
+	open_file_t *file = get_descriptor(fd);
+	return file != 0 && file->file != 0 ? file : 0;
+}
+
+// Primer descriptor libre desde el indice from
+static int64_t alloc_descriptor(open_file_t *files, int64_t from) {
+	for (int64_t i = from; i < MAX_OPEN_FILES; i++)
+		if (files[i].file == 0 && files[i].pipe == 0)
+			return i;
+	return -1;
+}
+
+int64_t file_open(const char *name) {
+	const bmfs_entry_t *entry = bmfs_find(name);
+	open_file_t *files = process_current()->files;
+	int64_t i = alloc_descriptor(files, 0);
+
+	if (entry == 0 || i < 0)
+		return -1;
+
+	files[i].file = entry;
+	files[i].offset = 0;
+	return FIRST_FILE_FD + i;
+}
+
+int64_t file_read(uint64_t fd, void *buffer, uint64_t count) {
+	open_file_t *file = get_descriptor(fd);
+	if (file == 0)
+		return -1;
+	if (file->pipe != 0)
+		return file->pipe_end == PIPE_READ ? pipe_read(file->pipe, buffer, count) : -1;
+
+	int64_t read = bmfs_read(file->file, file->offset, buffer, count);
+	if (read > 0)
+		file->offset += read;
+	return read;
+}
+
+int64_t file_write(uint64_t fd, const void *buffer, uint64_t count) {
+	open_file_t *file = get_descriptor(fd);
+	if (file == 0 || file->pipe == 0 || file->pipe_end != PIPE_WRITE)
+		return -1;
+	return pipe_write(file->pipe, buffer, count);
+}
+
+int64_t file_seek(uint64_t fd, uint64_t offset) {
+	open_file_t *file = get_file(fd);
+	if (file == 0 || offset > file->file->size)
+		return -1;
+
+	file->offset = offset;
+	return offset;
+}
+
+int64_t file_size(uint64_t fd) {
+	open_file_t *file = get_file(fd);
+	return file != 0 ? (int64_t)file->file->size : -1;
+}
+
+int64_t file_close(uint64_t fd) {
+	open_file_t *file = get_descriptor(fd);
+	if (file == 0)
+		return -1;
+
+	if (file->pipe != 0)
+		pipe_close(file->pipe, file->pipe_end);
+	file->file = 0;
+	file->pipe = 0;
+	return 0;
+}
+
+int64_t file_pipe(int64_t *fds, uint64_t flags) {
+	open_file_t *files = process_current()->files;
+	int64_t read_end = alloc_descriptor(files, 0);
+	int64_t write_end = read_end >= 0 ? alloc_descriptor(files, read_end + 1) : -1;
+
+	pipe_t *pipe = write_end >= 0 ? pipe_create(flags) : 0;
+	if (pipe == 0)
+		return -1;
+
+	files[read_end].pipe = pipe;
+	files[read_end].pipe_end = PIPE_READ;
+	files[write_end].pipe = pipe;
+	files[write_end].pipe_end = PIPE_WRITE;
+	fds[0] = FIRST_FILE_FD + read_end;
+	fds[1] = FIRST_FILE_FD + write_end;
+	return 0;
+}
+
+void file_inherit(process_t *child, const process_t *parent) {
+	memcpy(child->files, parent->files, sizeof(child->files));
+	for (int i = 0; i < MAX_OPEN_FILES; i++)
+		if (child->files[i].pipe != 0)
+			pipe_dup(child->files[i].pipe, child->files[i].pipe_end);
+}
+
+void file_close_all(process_t *process) {
+	for (int i = 0; i < MAX_OPEN_FILES; i++) {
+		if (process->files[i].pipe != 0)
+			pipe_close(process->files[i].pipe, process->files[i].pipe_end);
+		process->files[i].file = 0;
+		process->files[i].pipe = 0;
+	}
+}
+
+/*
+ * Las transferencias asincronicas van directo entre el disco y las paginas
+ * del proceso (sin pasar por el cache), asi que como con O_DIRECT el offset
+ * y la cantidad tienen que ser multiplos del sector.
+ */
+static int64_t submit_async(uint64_t fd, uint64_t buffer, uint64_t count, int write) {
+	open_file_t *file = get_file(fd);
+	dma_segment_t segments[DISK_MAX_REQUEST_SEGMENTS];
+	uint32_t segment_count = 0;
+
+	if (file == 0 || count == 0 || count % ATA_SECTOR_SIZE != 0 || file->offset % ATA_SECTOR_SIZE != 0 || buffer % 2 != 0)
+		return -1;
+
+	// Nunca mas alla del archivo (BMFS no cambia tamanios desde el kernel)
+	uint64_t available = SECTOR_ALIGN_UP(file->file->size) - file->offset;
+	if (count > available)
+		count = available;
+	if (count > MAX_ASYNC_BYTES)
+		count = MAX_ASYNC_BYTES;
+	if (count == 0)
+		return -1;
+
+	for (uint64_t done = 0; done < count; segment_count++) {
+		uint64_t address = buffer + done;
+		uint64_t length = PAGE_SIZE - address % PAGE_SIZE;
+		if (length > count - done)
+			length = count - done;
+
+		// Leer del disco es escribir en la memoria del proceso
+		uint64_t frame = process_pin_page(address, !write);
+		if (frame == 0) {
+			while (segment_count-- > 0)
+				pmm_free_frame(segments[segment_count].address & ~(uint64_t)(PAGE_SIZE - 1));
+			return -1;
+		}
+
+		segments[segment_count].address = frame + address % PAGE_SIZE;
+		segments[segment_count].length = length;
+		done += length;
+	}
+
+	uint64_t lba = file->file->start_block * SECTORS_PER_BMFS_BLOCK + file->offset / ATA_SECTOR_SIZE;
+	uint32_t sectors = count / ATA_SECTOR_SIZE;
+
+	// Lo que se escribe deja viejas las copias del cache
+	if (write)
+		cache_invalidate(lba / ATA_SECTORS_PER_PAGE, (sectors + lba % ATA_SECTORS_PER_PAGE + ATA_SECTORS_PER_PAGE - 1) / ATA_SECTORS_PER_PAGE);
+
+	int64_t id = disk_submit(lba, sectors, write, segments, segment_count, process_current()->pid, 1);
+	if (id < 0) {
+		for (uint32_t i = 0; i < segment_count; i++)
+			pmm_free_frame(segments[i].address & ~(uint64_t)(PAGE_SIZE - 1));
+		return -1;
+	}
+
+	file->offset += count;
+	if (file->offset > file->file->size)
+		file->offset = file->file->size;
+	return id;
+}
+
+int64_t file_read_async(uint64_t fd, void *buffer, uint64_t count) {
+	return submit_async(fd, (uint64_t)buffer, count, 0);
+}
+
+int64_t file_write_async(uint64_t fd, const void *buffer, uint64_t count) {
+	return submit_async(fd, (uint64_t)buffer, count, 1);
+}
+
+int64_t file_wait_async(int64_t id) {
+	return disk_wait(id, process_current()->pid);
+}
+
+uint64_t file_map(uint64_t fd, uint64_t offset, uint64_t length, uint64_t flags) {
+	open_file_t *file = get_file(fd);
+	return file != 0 ? mmap_create(process_current(), file->file, offset, length, flags) : 0;
+}
+
+int64_t file_unmap(uint64_t address) {
+	return mmap_remove(process_current(), address);
+}
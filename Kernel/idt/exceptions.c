@@ -1,13 +1,126 @@
+#include <stdint.h>
+#include <registers.h>
+#include <videoDriver.h>
+#include <lib.h>
+#include <process.h>
 
-#define ZERO_EXCEPTION_ID 0
+#define EXCEPTION_COUNT 32
+#define PAGE_FAULT_ID 14
 
-static void zero_division();
+#define DUMP_COLOR 0xFF0000
+#define DUMP_BUFFER_SIZE 1024
 
-void exceptionDispatcher(int exception) {
-	if (exception == ZERO_EXCEPTION_ID)
-		zero_division();
+static const char *exceptionNames[EXCEPTION_COUNT] = {
+	"Division by zero", "Debug", "NMI", "Breakpoint",
+	"Overflow", "Bound range exceeded", "Invalid opcode", "Device not available",
+	"Double fault", "Coprocessor segment overrun", "Invalid TSS", "Segment not present",
+	"Stack-segment fault", "General protection fault", "Page fault", "Reserved",
+	"x87 floating-point", "Alignment check", "Machine check", "SIMD floating-point",
+	"Virtualization", "Control protection", "Reserved", "Reserved",
+	"Reserved", "Reserved", "Reserved", "Reserved",
+	"Hypervisor injection", "VMM communication", "Security", "Reserved"
+};
+
+static void dumpRegisters(int exception, const exception_frame_t *frame);
+
+/*
+ * Los page faults de paginas on demand o copy-on-write se resuelven y se
+ * reintenta la instruccion. Cualquier otra excepcion vuelca el estado del CPU
+ * en pantalla y devuelve 0: el handler mata al proceso (si era el primero de
+ * userland, se vuelve a lanzar).
+ */
+int exceptionDispatcher(int exception, const exception_frame_t *frame) {
+	if (exception == PAGE_FAULT_ID && process_handle_page_fault(readCR2(), frame->error_code))
+		return 1;
+
+	dumpRegisters(exception, frame);
+	return 0;
+}
+
+//=============================================================================
+// CRASH DUMP
+//=============================================================================
+
+static char *appendString(char *dst, const char *str) {
+	while (*str)
+		*dst++ = *str++;
+	return dst;
+}
+
+static char *appendHex(char *dst, uint64_t value) {
+	for (int shift = 60; shift >= 0; shift -= 4) {
+		uint8_t digit = (value >> shift) & 0xF;
+		*dst++ = digit < 10 ? digit + '0' : digit - 10 + 'A';
+	}
+	return dst;
 }
 
-static void zero_division() {
-	// Handler para manejar excepcíon
-}
\ No newline at end of file
+static char *appendDec(char *dst, uint64_t value) {
+	char digits[20];
+	int count = 0;
+
+	do {
+		digits[count++] = value % 10 + '0';
+	} while (value /= 10);
+
+	while (count)
+		*dst++ = digits[--count];
+	return dst;
+}
+
+static char *appendRegister(char *dst, const char *name, uint64_t value) {
+	dst = appendString(dst, name);
+	dst = appendString(dst, "=");
+	dst = appendHex(dst, value);
+	return appendString(dst, " ");
+}
+
+/**
+ * Arma el dump completo en un buffer y lo escribe de una sola vez, asi el
+ * video driver renderiza una unica vez en lugar de una vez por registro.
+ */
+static void dumpRegisters(int exception, const exception_frame_t *frame) {
+	static char buffer[DUMP_BUFFER_SIZE];
+	const registers_t *r = &frame->registers;
+	char *p = buffer;
+
+	p = appendString(p, "\nException #");
+	p = appendDec(p, exception);
+	p = appendString(p, " (");
+	p = appendString(p, exception < EXCEPTION_COUNT ? exceptionNames[exception] : "Unknown");
+	p = appendString(p, ") err=");
+	p = appendHex(p, frame->error_code);
+	p = appendString(p, "\n");
+
+	p = appendRegister(p, "RIP", frame->rip);
+	p = appendRegister(p, "CS ", frame->cs);
+	p = appendRegister(p, "RFL", frame->rflags);
+	p = appendString(p, "\n");
+	p = appendRegister(p, "RSP", frame->rsp);
+	p = appendRegister(p, "SS ", frame->ss);
+	p = appendRegister(p, "CR2", readCR2());
+	p = appendString(p, "\n");
+
+	p = appendRegister(p, "RAX", r->rax);
+	p = appendRegister(p, "RBX", r->rbx);
+	p = appendRegister(p, "RCX", r->rcx);
+	p = appendString(p, "\n");
+	p = appendRegister(p, "RDX", r->rdx);
+	p = appendRegister(p, "RSI", r->rsi);
+	p = appendRegister(p, "RDI", r->rdi);
+	p = appendString(p, "\n");
+	p = appendRegister(p, "RBP", r->rbp);
+	p = appendRegister(p, "R8 ", r->r8);
+	p = appendRegister(p, "R9 ", r->r9);
+	p = appendString(p, "\n");
+	p = appendRegister(p, "R10", r->r10);
+	p = appendRegister(p, "R11", r->r11);
+	p = appendRegister(p, "R12", r->r12);
+	p = appendString(p, "\n");
+	p = appendRegister(p, "R13", r->r13);
+	p = appendRegister(p, "R14", r->r14);
+	p = appendRegister(p, "R15", r->r15);
+	p = appendString(p, "\nTerminating process...\n");
+
+	write_to_video_text_buffer(buffer, p - buffer, DUMP_COLOR);
+}
@@ -0,0 +1,76 @@
+#include <stdint.h>
+#include <gdtLoader.h>
+
+#define KERNEL_CODE_DESCRIPTOR 0x00209A0000000000ULL	// presente, DPL 0, ejecutable, 64 bits
+#define KERNEL_DATA_DESCRIPTOR 0x0000920000000000ULL	// presente, DPL 0, escritura
+#define TSS_SELECTOR 0x18
+#define TSS_AVAILABLE 0x89
+
+#define IST_STACK_SIZE 0x2000
+
+#pragma pack(push)		/* Push de la alineación actual */
+#pragma pack (1) 		/* Alinear las siguiente estructuras a 1 byte */
+
+/* Task State Segment de 64 bits: solo se usa por los stacks de la IST */
+typedef struct {
+  uint32_t reserved0;
+  uint64_t rsp[3];
+  uint64_t reserved1;
+  uint64_t ist[7];
+  uint64_t reserved2;
+  uint16_t reserved3;
+  uint16_t iomap_base;
+} TSS;
+
+typedef struct {
+  uint16_t limit;
+  uint64_t base;
+} GDTR;
+
+#pragma pack(pop)		/* Reestablece la alinceación actual */
+
+void loadGDT(GDTR *gdtr);
+void loadTR(uint16_t selector);
+
+/*
+ * Mismos selectores que deja Pure64 (codigo 0x08, datos 0x10) mas la TSS en 0x18,
+ * que ocupa dos entradas.
+ */
+static uint64_t gdt[5];
+static TSS tss;
+static GDTR gdtr;
+
+static uint8_t doubleFaultStack[IST_STACK_SIZE] __attribute__((aligned(16)));
+static uint8_t pageFaultStack[IST_STACK_SIZE] __attribute__((aligned(16)));
+static uint8_t bootKernelStack[IST_STACK_SIZE] __attribute__((aligned(16)));   // hasta que arranca el scheduler
+
+void load_gdt() {
+  uint64_t base = (uint64_t)&tss;
+  uint64_t limit = sizeof(tss) - 1;
+
+  tss.ist[IST_DOUBLE_FAULT - 1] = (uint64_t)(doubleFaultStack + IST_STACK_SIZE);
+  tss.ist[IST_PAGE_FAULT - 1] = (uint64_t)(pageFaultStack + IST_STACK_SIZE);
+  tss.ist[IST_KERNEL - 1] = (uint64_t)(bootKernelStack + IST_STACK_SIZE);
+  tss.iomap_base = sizeof(tss);
+
+  gdt[0] = 0;
+  gdt[1] = KERNEL_CODE_DESCRIPTOR;
+  gdt[2] = KERNEL_DATA_DESCRIPTOR;
+  gdt[3] = (limit & 0xFFFF) | ((base & 0xFFFFFF) << 16) | ((uint64_t)TSS_AVAILABLE << 40)
+         | (((limit >> 16) & 0xF) << 48) | (((base >> 24) & 0xFF) << 56);
+  gdt[4] = base >> 32;
+
+  gdtr.limit = sizeof(gdt) - 1;
+  gdtr.base = (uint64_t)gdt;
+
+  loadGDT(&gdtr);
+  loadTR(TSS_SELECTOR);
+}
+
+void set_page_fault_stack(uint64_t top) {
+  tss.ist[IST_PAGE_FAULT - 1] = top;
+}
+
+void set_kernel_stack(uint64_t top) {
+  tss.ist[IST_KERNEL - 1] = top;
+}
@@ -2,6 +2,7 @@
 #include <idtLoader.h>
 #include <defs.h>
 #include <interrupts.h>
+#include <gdtLoader.h>
 
 #pragma pack(push)		/* Push de la alineación actual */
 #pragma pack (1) 		/* Alinear las siguiente estructuras a 1 byte */
@@ -21,15 +22,46 @@ typedef struct {
 DESCR_INT * idt = (DESCR_INT *) 0;	// IDT de 255 entradas
 
 static void setup_IDT_entry (int index, uint64_t offset);
+static void setup_IDT_stack (int index, int ist);
+
+// Handlers de las 32 excepciones reservadas por Intel (vectores 0x00 - 0x1F)
+static void (*exceptionHandlers[])(void) = {
+  _exception0Handler, _exception1Handler, _exception2Handler, _exception3Handler,
+  _exception4Handler, _exception5Handler, _exception6Handler, _exception7Handler,
+  _exception8Handler, _exception9Handler, _exception10Handler, _exception11Handler,
+  _exception12Handler, _exception13Handler, _exception14Handler, _exception15Handler,
+  _exception16Handler, _exception17Handler, _exception18Handler, _exception19Handler,
+  _exception20Handler, _exception21Handler, _exception22Handler, _exception23Handler,
+  _exception24Handler, _exception25Handler, _exception26Handler, _exception27Handler,
+  _exception28Handler, _exception29Handler, _exception30Handler, _exception31Handler
+};
 
 void load_idt() {
-  setup_IDT_entry (0x00, (uint64_t)&_exception0Handler);
+  for (int i = 0; i < sizeof(exceptionHandlers) / sizeof(exceptionHandlers[0]); i++)
+    setup_IDT_entry (i, (uint64_t)exceptionHandlers[i]);
+
+  // Un stack conocido para las excepciones que pueden ocurrir con el stack roto
+  setup_IDT_stack (0x08, IST_DOUBLE_FAULT);
+  setup_IDT_stack (0x0E, IST_PAGE_FAULT);
+
   setup_IDT_entry (0x20, (uint64_t)&_irq00Handler);
+  setup_IDT_entry (0x21, (uint64_t)&_irq01Handler);
+  setup_IDT_entry (0x2E, (uint64_t)&_irq14Handler);
   setup_IDT_entry (0x80, (uint64_t)&_int80Handler);
+  setup_IDT_entry (0x81, (uint64_t)&_int81Handler);
 
-	//Solo interrupcion timer tick habilitadas
-	picMasterMask(0xFE); 
-	picSlaveMask(0xFF);
+  // Userland corre en CPL0: sin la IST, las IRQs y las syscalls se apilarian
+  // sobre su stack, que puede no estar mapeado. int 81h no la usa: solo la
+  // ejecuta el kernel, ya sobre el stack de kernel del proceso (o el de page
+  // faults), y volver al tope pisaria el frame de la syscall que cede el CPU.
+  setup_IDT_stack (0x20, IST_KERNEL);
+  setup_IDT_stack (0x21, IST_KERNEL);
+  setup_IDT_stack (0x2E, IST_KERNEL);
+  setup_IDT_stack (0x80, IST_KERNEL);
+
+	//Timer tick, teclado, cascada al esclavo y disco ATA primario (IRQ 14)
+	picMasterMask(0xF8); 
+	picSlaveMask(0xBF);
         
 	_sti();
 }
@@ -43,3 +75,7 @@ static void setup_IDT_entry (int index, uint64_t offset) {
   idt[index].cero = 0;
   idt[index].other_cero = (uint64_t) 0;
 }
+
+static void setup_IDT_stack (int index, int ist) {
+  idt[index].cero = ist;
+}
@@ -1,11 +1,55 @@
 #include <registers.h>
 #include <syscalls.h>
+#include <scheduler.h>
 
-static uint64_t (*intHandlers[])(uint64_t rdi, uint64_t rsi, uint64_t rdx, uint64_t rcx, uint64_t r8, uint64_t r9) = {sys_read, sys_write};
+typedef uint64_t (*syscall_handler_t)(uint64_t rdi, uint64_t rsi, uint64_t rdx, uint64_t rcx, uint64_t r8, uint64_t r9);
+
+// Indexado por el numero de syscall (rax)
+static syscall_handler_t intHandlers[] = {
+    (syscall_handler_t)sys_read,
+    (syscall_handler_t)sys_write,
+    (syscall_handler_t)sys_exit,
+    (syscall_handler_t)sys_fork,
+    (syscall_handler_t)sys_getpid,
+    (syscall_handler_t)sys_waitpid,
+    (syscall_handler_t)sys_yield,
+    (syscall_handler_t)sys_sbrk,
+    (syscall_handler_t)sys_spawn,
+    (syscall_handler_t)sys_exec,
+    (syscall_handler_t)sys_open,
+    (syscall_handler_t)sys_close,
+    (syscall_handler_t)sys_seek,
+    (syscall_handler_t)sys_fsize,
+    (syscall_handler_t)sys_spawn_file,
+    (syscall_handler_t)sys_aio_read,
+    (syscall_handler_t)sys_aio_write,
+    (syscall_handler_t)sys_aio_wait,
+    (syscall_handler_t)sys_mmap,
+    (syscall_handler_t)sys_munmap,
+    (syscall_handler_t)sys_boot_trace,
+    (syscall_handler_t)sys_pipe,
+    (syscall_handler_t)sys_clock,
+    (syscall_handler_t)sys_shm_create,
+    (syscall_handler_t)sys_shm_map,
+    (syscall_handler_t)sys_shm_destroy,
+    (syscall_handler_t)sys_futex_wait,
+    (syscall_handler_t)sys_futex_wake,
+    (syscall_handler_t)sys_thread_create,
+    (syscall_handler_t)sys_thread_join,
+    (syscall_handler_t)sys_gettid,
+    (syscall_handler_t)sys_fb_map,
+    (syscall_handler_t)sys_fb_present,
+    (syscall_handler_t)sys_gfx_submit,
+    (syscall_handler_t)sys_video_mode,
+    (syscall_handler_t)sys_fb_flip,
+    (syscall_handler_t)sys_set_console,
+    (syscall_handler_t)sys_exec_file
+};
 
 uint64_t intDispatcher(const registers_t *registers) {
     if (registers->rax >= sizeof(intHandlers) / sizeof(intHandlers[0]))
         return 0;
 
+    scheduler_current()->syscall_frame = registers;
     return intHandlers[registers->rax](registers->rdi, registers->rsi, registers->rdx, registers->rcx, registers->r8, registers->r9);
-}
\ No newline at end of file
+}
@@ -1,10 +1,25 @@
 #include <time.h>
 #include <registers.h>
+#include <diskQueue.h>
+#include <keyboardDriver.h>
 
-static void (*intHandlers[])(const registers_t *) = {timer_handler};
+// Los drivers no usan los registros: se adaptan a la firma de la tabla
+static void keyboard_irq(const registers_t *registers) {
+    keyboard_irq_handler();
+}
+
+static void disk_irq(const registers_t *registers) {
+    disk_irq_handler();
+}
+
+static void (*intHandlers[])(const registers_t *) = {
+    [0] = timer_handler,
+    [1] = keyboard_irq,
+    [14] = disk_irq
+};
 
 void irqDispatcher(uint64_t irq, const registers_t *registers) {
-    if (irq >= sizeof(intHandlers) / sizeof(intHandlers[0]))
+    if (irq >= sizeof(intHandlers) / sizeof(intHandlers[0]) || intHandlers[irq] == 0)
         return;
 
     intHandlers[irq](registers);
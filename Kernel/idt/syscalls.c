@@ -1,19 +1,190 @@
 #include <syscalls.h>
 #include <videoDriver.h>
+#include <process.h>
+#include <scheduler.h>
+#include <interrupts.h>
+#include <file.h>
+#include <time.h>
+#include <shm.h>
+#include <futex.h>
+#include <mmap.h>
 
 uint64_t sys_read(uint64_t fd, char *buf, uint64_t count) {
+  if (fd >= FIRST_FILE_FD)
+    return file_read(fd, buf, count);
   return 0;
 }
 
 uint64_t sys_write(uint64_t fd, const char *buf, uint64_t count) {
   switch (fd) {
     case 1:
-      write_to_video_text_buffer(buf, count, 0xFFFFFF);
+      write_to_console(process_current()->console, buf, count, 0xFFFFFF);
       return count;
     case 2:
-      write_to_video_text_buffer(buf, count, 0xFF0000);
+      write_to_console(process_current()->console, buf, count, 0xFF0000);
       return count;
     default:
-      return 0;
+      return file_write(fd, buf, count);
   }
-}
\ No newline at end of file
+}
+
+uint64_t sys_exit(int64_t code) {
+  process_exit(code);
+  return 0;
+}
+
+int64_t sys_fork(void) {
+  return process_fork();
+}
+
+uint64_t sys_getpid(void) {
+  return process_current()->pid;
+}
+
+int64_t sys_waitpid(int64_t pid, int64_t *status) {
+  return process_wait(pid, status);
+}
+
+uint64_t sys_yield(void) {
+  _yield();
+  return 0;
+}
+
+uint64_t sys_sbrk(int64_t increment) {
+  return process_sbrk(increment);
+}
+
+int64_t sys_spawn(uint64_t module) {
+  return process_spawn(module);
+}
+
+int64_t sys_exec(uint64_t module) {
+  return process_exec(module);
+}
+
+int64_t sys_open(const char *name) {
+  return file_open(name);
+}
+
+int64_t sys_close(uint64_t fd) {
+  return file_close(fd);
+}
+
+int64_t sys_seek(uint64_t fd, uint64_t offset) {
+  return file_seek(fd, offset);
+}
+
+int64_t sys_fsize(uint64_t fd) {
+  return file_size(fd);
+}
+
+int64_t sys_spawn_file(const char *name) {
+  return process_spawn_file(name);
+}
+
+int64_t sys_aio_read(uint64_t fd, void *buf, uint64_t count) {
+  return file_read_async(fd, buf, count);
+}
+
+int64_t sys_aio_write(uint64_t fd, const void *buf, uint64_t count) {
+  return file_write_async(fd, buf, count);
+}
+
+int64_t sys_aio_wait(int64_t id) {
+  return file_wait_async(id);
+}
+
+void *sys_mmap(uint64_t fd, uint64_t offset, uint64_t length, uint64_t flags) {
+  return (void *)file_map(fd, offset, length, flags);
+}
+
+int64_t sys_munmap(void *address) {
+  return file_unmap((uint64_t)address);
+}
+
+uint64_t sys_boot_trace(boot_trace_record_t *buffer, uint64_t max) {
+  return boot_trace_read(buffer, max);
+}
+
+int64_t sys_pipe(int64_t *fds, uint64_t flags) {
+  return file_pipe(fds, flags);
+}
+
+uint64_t sys_clock(void) {
+  return microseconds_elapsed();
+}
+
+int64_t sys_shm_create(uint64_t size) {
+  return shm_create(size);
+}
+
+void *sys_shm_map(int64_t id) {
+  return (void *)shm_map(id);
+}
+
+int64_t sys_shm_destroy(int64_t id) {
+  return shm_destroy(id);
+}
+
+int64_t sys_futex_wait(uint32_t *address, uint32_t expected) {
+  return futex_wait(address, expected);
+}
+
+int64_t sys_futex_wake(uint32_t *address, uint64_t count) {
+  return futex_wake(address, count);
+}
+
+int64_t sys_thread_create(uint64_t entry, uint64_t arg0, uint64_t arg1) {
+  return process_thread_create(entry, arg0, arg1);
+}
+
+int64_t sys_thread_join(int64_t tid, int64_t *status) {
+  return process_thread_join(tid, status);
+}
+
+uint64_t sys_gettid(void) {
+  return scheduler_current()->pid;
+}
+
+void *sys_fb_map(framebuffer_info_t *info, uint64_t flags) {
+  framebuffer_info_t framebuffer;
+  get_framebuffer_info(&framebuffer);
+
+  // El framebuffer se mapea con todas sus paginas, para sys_fb_flip
+  uint64_t size = (uint64_t)framebuffer.pitch * framebuffer.height;
+  uint64_t address = flags & FB_MAP_BACK_BUFFER
+      ? mmap_create_anonymous(process_current(), size)
+      : mmap_create_device(process_current(), framebuffer.address, size * framebuffer.pages);
+  if (address != 0 && info != 0)
+    *info = framebuffer;
+  return (void *)address;
+}
+
+uint64_t sys_fb_present(const uint8_t *buffer) {
+  present_framebuffer(buffer);
+  return 0;
+}
+
+uint64_t sys_gfx_submit(const gfx_command_t *commands, uint64_t count) {
+  return execute_gfx_commands(commands, count);
+}
+
+int64_t sys_video_mode(uint64_t width, uint64_t height, uint64_t bpp) {
+  return set_video_mode(width, height, bpp);
+}
+
+int64_t sys_fb_flip(uint64_t page) {
+  return show_framebuffer_page(page);
+}
+
+// Solo cambia donde escribe el proceso; la consola visible se elige con Alt+Fn
+int64_t sys_set_console(uint64_t console) {
+  if (console > 0xFFFFFFFF || !console_available(console))
+    return -1;
+  process_current()->console = console;
+  return 0;
+}
+
+int64_t sys_exec_file(const char *name) {
+  return process_exec_file(name);
+}
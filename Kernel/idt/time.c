@@ -1,4 +1,9 @@
+#include <stdint.h>
 #include <time.h>
+#include <lib.h>
+
+// Velocidad del CPU que Pure64 mide y deja en el InfoMap
+#define PURE64_CPU_SPEED ((uint16_t *)0x5010)    // MHz
 
 static unsigned long ticks = 0;
 
@@ -13,3 +18,13 @@ int ticks_elapsed() {
 int seconds_elapsed() {
 	return ticks / 18;
 }
+
+uint64_t cycles_to_microseconds(uint64_t cycles) {
+	uint64_t mhz = *PURE64_CPU_SPEED;
+	return mhz != 0 ? cycles / mhz : 0;
+}
+
+// El TSC arranca con el CPU, asi que cuenta desde el encendido
+uint64_t microseconds_elapsed() {
+	return cycles_to_microseconds(readTSC());
+}
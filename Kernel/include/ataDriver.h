@@ -0,0 +1,77 @@
+#ifndef ATA_DRIVER_H
+#define ATA_DRIVER_H
+
+#include <stdint.h>
+
+#define ATA_SECTOR_SIZE 512
+#define ATA_SECTORS_PER_PAGE 8
+#define ATA_MAX_DMA_SEGMENTS 512            // entradas de la PRD table (una pagina)
+#define ATA_MAX_DMA_SECTORS 65536
+
+// Region fisica de una transferencia DMA: debajo de 4 GiB, sin cruzar 64 KiB
+typedef struct {
+	uint64_t address;
+	uint32_t length;
+} dma_segment_t;
+
+//=============================================================================
+// ATA DISK (PRIMARY MASTER, PIO)
+//=============================================================================
+
+/**
+ * Detects the disk on the primary ATA bus (the boot disk in QEMU).
+ * @return 0 if a disk is present, -1 otherwise
+ */
+int ata_init(void);
+
+/**
+ * Gets the size of the disk.
+ * @return Number of 512-byte sectors, 0 if there is no disk
+ */
+uint64_t ata_sector_count(void);
+
+/**
+ * Reads consecutive sectors into 4 KiB pages with a single command.
+ * @param lba First sector to read (multiple of ATA_SECTORS_PER_PAGE)
+ * @param pages Destination of each group of ATA_SECTORS_PER_PAGE sectors
+ * @param count Number of pages to fill
+ * @return 0 on success, -1 on a device error
+ */
+int ata_read_pages(uint64_t lba, void **pages, uint32_t count);
+
+//=============================================================================
+// BUS MASTER DMA (PIIX IDE)
+//=============================================================================
+
+/**
+ * Looks for the PCI IDE controller, enables bus mastering and the disk
+ * interrupt (IRQ 14). Must be called after ata_init.
+ * @return 0 if DMA can be used, -1 if only PIO is available
+ */
+int ata_dma_init(void);
+
+/**
+ * Tells whether DMA transfers are available.
+ * @return 1 if ata_dma_init succeeded, 0 otherwise
+ */
+int ata_dma_available(void);
+
+/**
+ * Starts a DMA transfer. Completion is signaled with IRQ 14.
+ * @param lba First sector
+ * @param sectors Number of sectors (at most ATA_MAX_DMA_SECTORS)
+ * @param write 1 to write memory to the disk, 0 to read from it
+ * @param segments Memory to transfer, in order
+ * @param count Number of segments (at most ATA_MAX_DMA_SEGMENTS)
+ * @return 0 if the transfer started, -1 if the request is invalid
+ */
+int ata_dma_start(uint64_t lba, uint32_t sectors, int write, const dma_segment_t *segments, uint32_t count);
+
+/**
+ * Acknowledges the disk interrupt and stops the bus master.
+ * @return 0 if the transfer finished successfully, -1 if it failed,
+ *         1 if the interrupt was not for a finished transfer
+ */
+int ata_dma_finish(void);
+
+#endif
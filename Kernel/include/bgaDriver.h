@@ -0,0 +1,41 @@
+#ifndef BGA_DRIVER_H
+#define BGA_DRIVER_H
+
+#include <stdint.h>
+
+//=============================================================================
+// BOCHS GRAPHICS ADAPTER (VBE DISPI, PORTS 0x1CE/0x1CF)
+//=============================================================================
+
+/**
+ * Detects the Bochs VBE extensions (QEMU std VGA, Bochs) and grows the
+ * virtual height of the current mode to all the video memory, so the
+ * visible area can be panned.
+ * @return 0 if the adapter is present, -1 otherwise
+ */
+int bga_init(void);
+
+/**
+ * Switches to a linear framebuffer mode with the maximum virtual height.
+ * If the adapter rejects it the previous mode is restored.
+ * @param width Width in pixels
+ * @param height Height in pixels
+ * @param bpp Bits per pixel
+ * @return 0 on success, -1 if there is no adapter or the mode is not supported
+ */
+int bga_set_mode(uint16_t width, uint16_t height, uint16_t bpp);
+
+/**
+ * Gets the geometry of the current mode as the adapter sees it.
+ * @param pitch Where to store the bytes per line (virtual width * bytes per pixel)
+ * @param virtual_height Where to store the number of lines of video memory in use
+ */
+void bga_get_geometry(uint32_t *pitch, uint32_t *virtual_height);
+
+/**
+ * Sets the first line of video memory shown at the top of the screen.
+ * @param y Line, between 0 and virtual height - height
+ */
+void bga_set_y_offset(uint16_t y);
+
+#endif
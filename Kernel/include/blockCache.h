@@ -0,0 +1,55 @@
+#ifndef BLOCK_CACHE_H
+#define BLOCK_CACHE_H
+
+#include <stdint.h>
+
+#define CACHE_BLOCK_SIZE 0x1000             // un frame por bloque
+#define CACHE_BLOCKS 512                    // 2 MiB cacheados
+#define CACHE_READAHEAD_BLOCKS 32           // 128 KiB por lectura
+
+//=============================================================================
+// DISK BLOCK CACHE
+//=============================================================================
+
+/**
+ * Initializes the (empty) cache. Frames are taken from the PMM as needed.
+ */
+void cache_init(void);
+
+/**
+ * Gets the frame that holds a 4 KiB disk block, reading it on a miss.
+ * A miss also reads ahead the following blocks that are not cached yet,
+ * in the same disk command, as long as they are before limit.
+ * May block while the disk works. The frame is only guaranteed until the
+ * caller blocks or calls the cache again; take a reference with
+ * pmm_ref_frame to keep it (evicting then just drops the cache's one).
+ * @param block Block number (disk offset / CACHE_BLOCK_SIZE)
+ * @param limit First block that must not be read ahead (end of the file)
+ * @return Physical address of the frame, or 0 on a disk error
+ */
+uint64_t cache_get_block(uint64_t block, uint64_t limit);
+
+/**
+ * Gets the frame of a block only if it is already cached: never touches the
+ * disk nor blocks. Same lifetime rules as cache_get_block.
+ * @param block Block number
+ * @return Physical address of the frame, or 0 if it is not in memory
+ */
+uint64_t cache_peek_block(uint64_t block);
+
+/**
+ * Forgets cached blocks after they were written to the disk behind the
+ * cache's back. Frames still mapped by processes keep the old contents.
+ * @param block First block
+ * @param count Number of blocks
+ */
+void cache_invalidate(uint64_t block, uint64_t count);
+
+/**
+ * Gets the cache hit and miss counters.
+ * @param hits Where to store the number of lookups served from memory
+ * @param misses Where to store the number of lookups that read the disk
+ */
+void cache_stats(uint64_t *hits, uint64_t *misses);
+
+#endif
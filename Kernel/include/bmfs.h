@@ -0,0 +1,65 @@
+#ifndef BMFS_H
+#define BMFS_H
+
+#include <stdint.h>
+
+#define BMFS_BLOCK_SIZE 0x200000            // 2 MiB
+#define BMFS_MAX_FILES 64
+#define BMFS_NAME_LENGTH 32
+
+// Registro del directorio, tal como esta en el disco
+typedef struct {
+	char name[BMFS_NAME_LENGTH];            // 0x00 fin del directorio, 0x01 libre
+	uint64_t start_block;
+	uint64_t reserved_blocks;
+	uint64_t size;
+	uint64_t unused;
+} bmfs_entry_t;
+
+//=============================================================================
+// BAREMETAL FILE SYSTEM (READ ONLY)
+//=============================================================================
+
+/**
+ * Reads the BMFS marker and directory of the boot disk.
+ * @return 0 if the disk holds a BMFS volume, -1 otherwise
+ */
+int bmfs_init(void);
+
+/**
+ * Looks a file up in the directory.
+ * @param name Null-terminated file name
+ * @return The directory record, or 0 if there is no such file
+ */
+const bmfs_entry_t *bmfs_find(const char *name);
+
+/**
+ * Copies part of a file through the block cache.
+ * @param file File to read
+ * @param offset First byte to read
+ * @param buffer Destination
+ * @param count Maximum number of bytes to read
+ * @return Number of bytes read (less than count at the end of the file), or
+ *         -1 on a disk error
+ */
+int64_t bmfs_read(const bmfs_entry_t *file, uint64_t offset, void *buffer, uint64_t count);
+
+/**
+ * Gets the frame that caches a page of a file, with a new reference that
+ * the caller must drop with pmm_free_frame.
+ * @param file File to read
+ * @param offset Page-aligned offset inside the file
+ * @return Physical address of the frame, or 0 on a disk error
+ */
+uint64_t bmfs_page(const bmfs_entry_t *file, uint64_t offset);
+
+/**
+ * Like bmfs_page, but only if the page is already in the block cache.
+ * @param file File to read
+ * @param offset Page-aligned offset inside the file
+ * @return Physical address of the frame (with a new reference), or 0 if it
+ *         is not cached
+ */
+uint64_t bmfs_cached_page(const bmfs_entry_t *file, uint64_t offset);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef BOOT_TRACE_H
+#define BOOT_TRACE_H
+
+#include <stdint.h>
+
+#define BOOT_TRACE_MAX 16
+#define BOOT_TRACE_NAME_LENGTH 24
+
+// Lo que ve userland por cada punto del boot
+typedef struct {
+	char name[BOOT_TRACE_NAME_LENGTH];
+	uint64_t tsc;
+	uint64_t microseconds;                  // desde el primer punto registrado
+} boot_trace_record_t;
+
+//=============================================================================
+// BOOT TRACE
+//=============================================================================
+
+/**
+ * Starts the trace with the points recorded before the kernel had a .bss:
+ * the ones Pure64 leaves in the InfoMap and the kernel loader entry.
+ * Must be called right after clearing the .bss.
+ */
+void boot_trace_init(void);
+
+/**
+ * Records a boot point with the current TSC. Extra points are ignored.
+ * @param name Static string naming the point
+ */
+void boot_trace(const char *name);
+
+/**
+ * Records a boot point measured earlier.
+ * @param name Static string naming the point
+ * @param tsc Time Stamp Counter at that point
+ */
+void boot_trace_at(const char *name, uint64_t tsc);
+
+/**
+ * Prints every point with the time elapsed since the previous one.
+ */
+void boot_trace_print(void);
+
+/**
+ * Copies the trace for userland.
+ * @param buffer Destination
+ * @param max Maximum number of records to copy
+ * @return Number of records copied
+ */
+uint64_t boot_trace_read(boot_trace_record_t *buffer, uint64_t max);
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef DISK_QUEUE_H
+#define DISK_QUEUE_H
+
+#include <stdint.h>
+#include <ataDriver.h>
+
+#define DISK_MAX_REQUESTS 32
+#define DISK_MAX_REQUEST_SEGMENTS 128       // 512 KiB en paginas de 4 KiB
+
+//=============================================================================
+// ASYNCHRONOUS DISK REQUEST QUEUE
+//=============================================================================
+
+/**
+ * Queues a DMA transfer. Requests for consecutive sectors in the same
+ * direction are merged into a single disk command when they are started,
+ * as long as that does not move one ahead of an earlier request that
+ * overlaps it with a write.
+ * @param lba First sector
+ * @param sectors Number of sectors
+ * @param write 1 to write memory to the disk, 0 to read from it
+ * @param segments Memory to transfer, in order
+ * @param count Number of segments (at most DISK_MAX_REQUEST_SEGMENTS)
+ * @param owner Pid that may wait for the request, 0 for the kernel
+ * @param pinned 1 if every segment holds a frame reference to drop when the
+ *        request is released
+ * @return Request id, or -1 if the queue is full or DMA is not available
+ */
+int64_t disk_submit(uint64_t lba, uint32_t sectors, int write, const dma_segment_t *segments, uint32_t count,
+		uint64_t owner, int pinned);
+
+/**
+ * Blocks until a request completes and releases it.
+ * @param id Request id
+ * @param owner Pid that submitted it, 0 for the kernel
+ * @return 0 on success, -1 if the transfer failed or the id is not valid
+ */
+int disk_wait(int64_t id, uint64_t owner);
+
+/**
+ * Synchronous read of whole pages, by DMA when available and by PIO when not.
+ * @param lba First sector
+ * @param pages Kernel addresses of the destination pages
+ * @param count Number of pages
+ * @return 0 on success, -1 on error
+ */
+int disk_read_pages(uint64_t lba, void **pages, uint32_t count);
+
+/**
+ * Forgets every request of a process that is going away. Unfinished ones
+ * are released by the interrupt handler when the device is done with them.
+ * @param owner Pid of the process
+ */
+void disk_release_owner(uint64_t owner);
+
+/**
+ * Completes the running transfer and starts the next one. Called on IRQ 14.
+ */
+void disk_irq_handler(void);
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef ELF_H
+#define ELF_H
+
+#include <stdint.h>
+#include <paging.h>
+#include <process.h>
+
+// Solo lo necesario de ELF64 para cargar ejecutables estaticos (ET_EXEC)
+#define ELF_MAGIC 0x464C457F            // "\x7FELF"
+#define ELFCLASS64 2
+#define ELFDATA2LSB 1
+#define ET_EXEC 2
+#define EM_X86_64 62
+
+#define PT_LOAD 1
+#define PF_X 0x1
+#define PF_W 0x2
+#define PF_R 0x4
+
+typedef struct {
+	uint32_t e_magic;
+	uint8_t e_class;
+	uint8_t e_data;
+	uint8_t e_version_ident;
+	uint8_t e_pad[9];
+	uint16_t e_type;
+	uint16_t e_machine;
+	uint32_t e_version;
+	uint64_t e_entry;
+	uint64_t e_phoff;
+	uint64_t e_shoff;
+	uint32_t e_flags;
+	uint16_t e_ehsize;
+	uint16_t e_phentsize;
+	uint16_t e_phnum;
+	uint16_t e_shentsize;
+	uint16_t e_shnum;
+	uint16_t e_shstrndx;
+} elf64_header_t;
+
+typedef struct {
+	uint32_t p_type;
+	uint32_t p_flags;
+	uint64_t p_offset;
+	uint64_t p_vaddr;
+	uint64_t p_paddr;
+	uint64_t p_filesz;
+	uint64_t p_memsz;
+	uint64_t p_align;
+} elf64_program_header_t;
+
+/**
+ * Gets the frame holding a page of an executable, with a reference for the
+ * caller (dropped with pmm_free_frame, or handed over to a mapping).
+ * @param source Executable being loaded
+ * @param offset Page-aligned offset inside the executable
+ * @return Physical address of the frame, or 0 on error
+ */
+typedef uint64_t (*elf_page_reader_t)(const void *source, uint64_t offset);
+
+/**
+ * Maps the PT_LOAD segments of an ELF64 executable into an address space.
+ * Pages fully backed by the file are mapped in place (shared, copy-on-write
+ * if writable); only the page where a segment's file data ends is copied.
+ * The rest of each segment (.bss) is returned as regions to zero-fill lazily.
+ * @param space Target address space
+ * @param read_page Gives the frames of the executable
+ * @param source Executable passed to read_page
+ * @param size Size of the executable in bytes
+ * @param entry Where to store the entry point
+ * @param bss Where to store the regions to zero-fill on first touch
+ * @return Number of bss regions (at most MAX_BSS_REGIONS), or -1 if the
+ *         executable is invalid or memory is exhausted
+ */
+int elf_load(address_space_t *space, elf_page_reader_t read_page, const void *source, uint64_t size, uint64_t *entry, bss_region_t *bss);
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef FILE_H
+#define FILE_H
+
+#include <stdint.h>
+
+struct process;
+
+//=============================================================================
+// FILE DESCRIPTORS (CURRENT PROCESS)
+//=============================================================================
+
+/**
+ * Opens a BMFS file for reading.
+ * @param name File name
+ * @return New file descriptor, or -1 if the file does not exist or the
+ *         process has no free descriptors
+ */
+int64_t file_open(const char *name);
+
+/**
+ * Reads from an open file and advances its offset.
+ * @param fd File descriptor
+ * @param buffer Destination
+ * @param count Maximum number of bytes to read
+ * @return Number of bytes read (0 at the end of the file), or -1 on error
+ */
+int64_t file_read(uint64_t fd, void *buffer, uint64_t count);
+
+/**
+ * Writes to an open descriptor. Only the write end of a pipe can be
+ * written: BMFS files are written with file_write_async.
+ * @param fd File descriptor
+ * @param buffer Source
+ * @param count Bytes to write
+ * @return Number of bytes written, or -1 on error
+ */
+int64_t file_write(uint64_t fd, const void *buffer, uint64_t count);
+
+/**
+ * Moves the offset of an open file.
+ * @param fd File descriptor
+ * @param offset New offset from the start of the file
+ * @return The new offset, or -1 on error
+ */
+int64_t file_seek(uint64_t fd, uint64_t offset);
+
+/**
+ * Gets the size of an open file.
+ * @param fd File descriptor
+ * @return Size in bytes, or -1 on error
+ */
+int64_t file_size(uint64_t fd);
+
+/**
+ * Closes a file descriptor.
+ * @param fd File descriptor
+ * @return 0 on success, -1 if it was not open
+ */
+int64_t file_close(uint64_t fd);
+
+//=============================================================================
+// PIPES
+//=============================================================================
+
+/**
+ * Creates a pipe and opens both ends in the current process.
+ * @param fds Where to store the read end (fds[0]) and the write end (fds[1])
+ * @param flags PIPE_* flags
+ * @return 0 on success, -1 if no descriptors or pipes are left
+ */
+int64_t file_pipe(int64_t *fds, uint64_t flags);
+
+/**
+ * Gives a child a copy of the descriptors of its parent (fork), taking
+ * new references to the pipes.
+ * @param child New process
+ * @param parent Process being duplicated
+ */
+void file_inherit(struct process *child, const struct process *parent);
+
+/**
+ * Closes every descriptor of a process that is terminating, so the other
+ * end of its pipes sees end of file or a broken pipe.
+ * @param process Terminating process
+ */
+void file_close_all(struct process *process);
+
+//=============================================================================
+// ASYNCHRONOUS I/O (DMA STRAIGHT TO PROCESS MEMORY)
+//=============================================================================
+
+/**
+ * Starts reading from an open file into memory without waiting. The file
+ * offset and count must be multiples of 512 and the buffer 2-byte aligned.
+ * Whole sectors are transferred, so the buffer must hold count bytes even
+ * at the end of the file. The file offset advances right away.
+ * @param fd File descriptor
+ * @param buffer Destination, kept pinned until the request is waited for
+ * @param count Bytes to read (clamped to the file and to 508 KiB)
+ * @return Request id for file_wait_async, or -1 on error
+ */
+int64_t file_read_async(uint64_t fd, void *buffer, uint64_t count);
+
+/**
+ * Starts writing memory over the existing contents of an open file without
+ * waiting. Same alignment rules as file_read_async; files never grow.
+ * @param fd File descriptor
+ * @param buffer Source, kept pinned until the request is waited for
+ * @param count Bytes to write (clamped to the file and to 508 KiB)
+ * @return Request id for file_wait_async, or -1 on error
+ */
+int64_t file_write_async(uint64_t fd, const void *buffer, uint64_t count);
+
+/**
+ * Waits for an asynchronous request of the current process.
+ * @param id Request id
+ * @return 0 on success, -1 if the transfer failed or the id is not valid
+ */
+int64_t file_wait_async(int64_t id);
+
+//=============================================================================
+// MEMORY-MAPPED FILES
+//=============================================================================
+
+/**
+ * Maps part of an open file in the address space of the current process.
+ * Pages are read from the block cache the first time they are touched.
+ * The mapping survives closing the file descriptor.
+ * @param fd File descriptor
+ * @param offset Page-aligned offset inside the file
+ * @param length Bytes to map (clamped to the end of the file)
+ * @param flags MMAP_WRITABLE for a private copy-on-write mapping
+ * @return Start of the mapping, or 0 on error
+ */
+uint64_t file_map(uint64_t fd, uint64_t offset, uint64_t length, uint64_t flags);
+
+/**
+ * Removes a mapping of the current process.
+ * @param address Start of the mapping, as returned by file_map
+ * @return 0 on success, -1 if there is no mapping there
+ */
+int64_t file_unmap(uint64_t address);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef FUTEX_H
+#define FUTEX_H
+
+#include <stdint.h>
+
+#define MAX_FUTEXES 32                      // direcciones con alguien esperando a la vez
+
+//=============================================================================
+// FUTEXES
+//=============================================================================
+
+/**
+ * Sleeps on a 32-bit word of the current process if it still holds the
+ * expected value. The word is identified by its physical address, so
+ * processes sharing memory wait on the same futex. Wakeups may be spurious:
+ * callers re-check the word.
+ * @param address 4-byte aligned user address
+ * @param expected Value the word must hold to sleep
+ * @return 0 after being woken, -1 if the value had changed or the address
+ *         is not valid
+ */
+int64_t futex_wait(uint32_t *address, uint32_t expected);
+
+/**
+ * Wakes processes sleeping on a word, in the order they started waiting.
+ * @param address User address the waiters passed to futex_wait
+ * @param count Maximum number of processes to wake
+ * @return Number of processes woken, or -1 if the address is not valid
+ */
+int64_t futex_wake(uint32_t *address, uint64_t count);
+
+#endif
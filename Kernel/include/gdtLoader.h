@@ -0,0 +1,27 @@
+//******************************************************************************
+// Archivo: gdtLoader.h
+//******************************************************************************
+
+#ifndef _GDTLOADER_H_
+#define _GDTLOADER_H_
+
+#include <stdint.h>
+
+// Stacks alternativos (Interrupt Stack Table) de la TSS
+#define IST_DOUBLE_FAULT 1
+#define IST_PAGE_FAULT   2
+#define IST_KERNEL       3                 // IRQs y syscalls: nunca sobre el stack del programa
+
+//******************************************************************************
+// DECLARACIÓN DE PROTOTIPOS
+//******************************************************************************
+
+void load_gdt();
+
+// Cambia el stack de la IST con que se atienden los page faults
+void set_page_fault_stack(uint64_t top);
+
+// Cambia el stack de la IST con que se atienden las IRQs y las syscalls
+void set_kernel_stack(uint64_t top);
+
+#endif // _GDTLOADER_H_
@@ -0,0 +1,17 @@
+#ifndef KEYBOARD_DRIVER_H
+#define KEYBOARD_DRIVER_H
+
+#include <stdint.h>
+
+//=============================================================================
+// PS/2 KEYBOARD (IRQ 1, SCAN CODE SET 1)
+//=============================================================================
+
+/**
+ * Reads a scan code and handles the console keys: Shift+PgUp and
+ * Shift+PgDn page the text console through its scrollback history, and
+ * Alt+Fn shows virtual console n - 1. Called on IRQ 1.
+ */
+void keyboard_irq_handler(void);
+
+#endif
@@ -5,7 +5,29 @@
 
 void * memset(void * destination, int32_t character, uint64_t length);
 void * memcpy(void * destination, const void * source, uint64_t length);
+void * memmove(void * destination, const void * source, uint64_t length);
+int strncmp(const char * first, const char * second, uint64_t length);
+int memcmp(const void * first, const void * second, uint64_t length);
 
 char *cpuVendor(char *result);
+uint64_t readCR0(void);
+void writeCR0(uint64_t value);
+uint64_t readCR2(void);
+uint64_t readCR3(void);
+void writeCR3(uint64_t value);
+uint64_t readCR4(void);
+void writeCR4(uint64_t value);
+void invalidatePage(uint64_t address);
+void _cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]);
+uint64_t readMSR(uint32_t msr);
+void writeMSR(uint32_t msr, uint64_t value);
+void outb(uint16_t port, uint8_t value);
+uint8_t inb(uint16_t port);
+void outw(uint16_t port, uint16_t value);
+uint16_t inw(uint16_t port);
+void insw(uint16_t port, void * buffer, uint64_t count);
+void outl(uint16_t port, uint32_t value);
+uint32_t inl(uint16_t port);
+uint64_t readTSC(void);
 
 #endif
\ No newline at end of file
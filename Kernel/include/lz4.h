@@ -0,0 +1,21 @@
+#ifndef LZ4_H
+#define LZ4_H
+
+#include <stdint.h>
+
+//=============================================================================
+// LZ4 BLOCK DECOMPRESSION
+//=============================================================================
+
+/**
+ * Decompresses an LZ4 block (as written by the ModulePacker with -c).
+ * @param source Compressed block
+ * @param sourceSize Bytes in the block
+ * @param destination Where to write the decompressed data
+ * @param size Exact size of the decompressed data
+ * @return 0 on success, -1 if the block is corrupt or does not decompress
+ *         to exactly size bytes
+ */
+int lz4_decompress(const void *source, uint64_t sourceSize, void *destination, uint64_t size);
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef MMAP_H
+#define MMAP_H
+
+#include <stdint.h>
+#include <bmfs.h>
+
+#define MAX_MMAP_REGIONS 8
+#define MMAP_ALIGNMENT 0x200000             // como los bloques de BMFS
+#define MMAP_FAULT_AROUND_PAGES 16
+
+// Flags de mmap
+#define MMAP_WRITABLE 0x1                   // copia privada: no se escribe al disco
+
+typedef struct {
+	uint64_t start;
+	uint64_t end;
+	const bmfs_entry_t *file;               // 0 para memoria compartida
+	uint64_t offset;                        // offset en el archivo de start
+	uint64_t flags;                         // PAGE_* de las paginas compartidas
+	uint8_t anonymous;                      // paginas en cero que se crean al tocarlas
+} mmap_region_t;
+
+struct process;
+
+//=============================================================================
+// FILE MAPPINGS
+//=============================================================================
+
+/**
+ * Maps part of a file in the mmap area of a process. Nothing is read until
+ * the pages are touched; they then share the frames of the block cache.
+ * @param process Owner of the mapping
+ * @param file File to map
+ * @param offset Page-aligned offset inside the file
+ * @param length Bytes to map (clamped to the end of the file)
+ * @param flags MMAP_* flags
+ * @return Start of the mapping (2 MiB aligned), or 0 on error
+ */
+uint64_t mmap_create(struct process *process, const bmfs_entry_t *file, uint64_t offset, uint64_t length, uint64_t flags);
+
+/**
+ * Maps shared memory frames in the mmap area of a process, all at once and
+ * writable. Each page takes a reference to its frame; fork keeps sharing them.
+ * @param process Owner of the mapping
+ * @param frames Physical addresses of the pages
+ * @param pages Number of pages
+ * @return Start of the mapping (2 MiB aligned), or 0 on error
+ */
+uint64_t mmap_create_shared(struct process *process, const uint64_t *frames, uint64_t pages);
+
+/**
+ * Maps private zeroed memory in the mmap area of a process. Pages are
+ * allocated when first touched and copied on write after fork.
+ * @param process Owner of the mapping
+ * @param length Bytes to map (rounded up to pages)
+ * @return Start of the mapping (2 MiB aligned), or 0 on error
+ */
+uint64_t mmap_create_anonymous(struct process *process, uint64_t length);
+
+/**
+ * Maps a range of device memory (outside the frame pool) in the mmap area
+ * of a process, all at once and writable. Fork keeps sharing it.
+ * @param process Owner of the mapping
+ * @param phys Page-aligned physical address
+ * @param length Bytes to map (rounded up to pages)
+ * @return Start of the mapping (2 MiB aligned), or 0 on error
+ */
+uint64_t mmap_create_device(struct process *process, uint64_t phys, uint64_t length);
+
+/**
+ * Removes a mapping and drops the references to its frames.
+ * @param process Owner of the mapping
+ * @param address Start of the mapping, as returned by mmap_create
+ * @return 0 on success, -1 if there is no mapping there
+ */
+int mmap_remove(struct process *process, uint64_t address);
+
+/**
+ * Finds the mapping that holds an address.
+ * @param process Process to look up
+ * @param address Virtual address
+ * @return The mapping, or 0 if the address is not mapped from a file
+ */
+const mmap_region_t *mmap_find(const struct process *process, uint64_t address);
+
+/**
+ * Brings in a missing page of a mapping from the block cache, plus the
+ * following pages that are already cached, or a zeroed page for anonymous
+ * mappings. May block while the disk works.
+ * @param process Faulting process (the current one)
+ * @param region Mapping that holds the address
+ * @param address Faulting address
+ * @return 1 if the page was mapped, 0 if it is past the end of the file or
+ *         memory is exhausted
+ */
+int mmap_handle_fault(struct process *process, const mmap_region_t *region, uint64_t address);
+
+#endif
@@ -1,6 +1,68 @@
 #ifndef MODULELOADER_H
 #define MODULELOADER_H
 
-void loadModules(void * payloadStart, void ** moduleTargetAddress);
+#include <stdint.h>
 
-#endif
\ No newline at end of file
+#define MAX_MODULES 32                      // el ModulePacker no acepta mas
+#define MODULE_ALIGNMENT 0x1000
+#define MODULE_NAME_LENGTH 32
+#define MODULE_INDEX_MAGIC 0x53444F4D      // "MODS"
+#define MODULE_LZ4 0x1                      // guardado como bloque LZ4
+
+// Los modulos comprimidos se descomprimen aca (reservado, identity del kernel)
+#define MODULE_AREA_START 0x400000
+#define MODULE_AREA_END 0xA00000
+
+// Tabla que el ModulePacker deja al principio del payload
+typedef struct __attribute__((packed)) {
+	uint32_t magic;
+	uint32_t count;
+} module_index_header_t;
+
+typedef struct __attribute__((packed)) {
+	char name[MODULE_NAME_LENGTH];
+	uint64_t offset;        // desde el principio del payload
+	uint64_t size;          // descomprimido
+	uint64_t packed_size;   // lo que ocupa en el payload
+	uint32_t checksum;      // CRC-32 del modulo descomprimido
+	uint32_t flags;
+} module_index_entry_t;
+
+typedef struct {
+	void * address;         // alineada a pagina; 0 si estaba corrupto
+	uint64_t size;
+	char name[MODULE_NAME_LENGTH];
+} module_t;
+
+/**
+ * Records every module listed in the index table of the packed payload.
+ * Modules are page aligned and zero padded by the ModulePacker, so they are
+ * used in place (never copied); compressed ones are decompressed into the
+ * module area. Modules whose checksum does not match are left out, keeping
+ * the index of the others. Entries past MAX_MODULES are dropped and reported.
+ * @param payloadStart First byte after the kernel binary
+ */
+void loadModules(void * payloadStart);
+
+/**
+ * Gets how many modules were loaded at boot.
+ * @return Number of modules
+ */
+uint32_t getModuleCount(void);
+
+/**
+ * Gets a module loaded at boot.
+ * @param index Position of the module in the payload
+ * @return The module, or 0 if there is no such module
+ */
+const module_t * getModule(uint32_t index);
+
+/**
+ * Looks a module up by the name it has in the index table (its file name
+ * without directory nor extension, e.g. "0000-sampleCodeModule").
+ * @param name Null-terminated module name
+ * @return Index of the module, or -1 if there is no such module
+ */
+int findModule(const char * name);
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef PAGING_H
+#define PAGING_H
+
+#include <stdint.h>
+
+// Flags de las entradas de las tablas de paginas
+#define PAGE_PRESENT   (1ULL << 0)
+#define PAGE_WRITABLE  (1ULL << 1)
+#define PAGE_USER      (1ULL << 2)
+#define PAGE_HUGE      (1ULL << 7)
+#define PAGE_GLOBAL    (1ULL << 8)
+#define PAGE_COW       (1ULL << 9)      // bit libre para el SO: copiar al escribir
+#define PAGE_SHARED    (1ULL << 10)     // bit libre para el SO: memoria compartida, fork no la copia
+#define PAGE_NX        (1ULL << 63)
+
+#define PAGE_ADDRESS_MASK 0x000FFFFFFFFFF000ULL
+
+/*
+ * Layout de cada espacio de direcciones:
+ *   0x000000 - 0x9FFFFF       kernel, identity con paginas de 2 MiB (compartido)
+ *   USER_SPACE_START - END    userland, paginas de 4 KiB (privado)
+ *   1 GiB - 4 GiB             identity con paginas grandes (framebuffer, APICs)
+ *   DIRECT_MAP_BASE           toda la memoria fisica (compartido)
+ */
+#define USER_SPACE_START 0xA00000ULL
+#define USER_SPACE_END   0x40000000ULL
+
+typedef struct {
+	uint64_t pml4;          // direccion fisica de la PML4
+	uint16_t pcid;          // 0 si el CPU no soporta PCID o no quedaron libres
+	uint8_t needs_flush;    // la proxima carga de CR3 debe invalidar la TLB del PCID
+	uint8_t in_use;
+} address_space_t;
+
+//=============================================================================
+// ADDRESS SPACE MANAGEMENT
+//=============================================================================
+
+/**
+ * Builds the kernel page tables (identity low memory, large-page mappings for
+ * MMIO and the direct map) and switches CR3 to them. Enables PCID and NX if
+ * available.
+ */
+void paging_init(void);
+
+/**
+ * Creates an empty user address space that shares the kernel mappings.
+ * @return The new address space, or 0 if no memory or slots are left
+ */
+address_space_t *paging_create_address_space(void);
+
+/**
+ * Releases an address space, its page tables and every frame mapped in its
+ * user region. Switches to the kernel space first if it is the current one.
+ * @param space Address space to destroy
+ */
+void paging_destroy_address_space(address_space_t *space);
+
+/**
+ * Loads an address space into CR3, tagged with its PCID so the switch does
+ * not flush the TLB when the CPU supports it.
+ * @param space Address space to activate
+ */
+void paging_switch(address_space_t *space);
+
+/**
+ * Gets the kernel address space (no user mappings).
+ * @return The kernel address space
+ */
+address_space_t *paging_kernel_space(void);
+
+/**
+ * Gets the currently active address space.
+ * @return The active address space
+ */
+address_space_t *paging_current(void);
+
+//=============================================================================
+// USER MAPPINGS (4 KiB)
+//=============================================================================
+
+/**
+ * Maps one 4 KiB page in the user region.
+ * @param space Target address space
+ * @param virt Page-aligned virtual address inside the user region
+ * @param phys Page-aligned physical address
+ * @param flags PAGE_* flags (PAGE_PRESENT is implied, PAGE_NX is dropped if unsupported)
+ * @return 0 on success, -1 if the address is invalid or memory is exhausted
+ */
+int paging_map(address_space_t *space, uint64_t virt, uint64_t phys, uint64_t flags);
+
+/**
+ * Removes the mapping of one 4 KiB user page. The frame is not released.
+ * @param space Target address space
+ * @param virt Page-aligned virtual address
+ * @return Physical address that was mapped, or 0 if none
+ */
+uint64_t paging_unmap(address_space_t *space, uint64_t virt);
+
+/**
+ * Translates a user virtual address.
+ * @param space Address space to look up
+ * @param virt Virtual address
+ * @return Physical address, or 0 if the page is not mapped
+ */
+uint64_t paging_translate(address_space_t *space, uint64_t virt);
+
+/**
+ * Gets the flags of a user page mapping.
+ * @param space Address space to look up
+ * @param virt Virtual address
+ * @return PAGE_* flags of the mapping, or 0 if the page is not mapped
+ */
+uint64_t paging_flags(address_space_t *space, uint64_t virt);
+
+//=============================================================================
+// COPY-ON-WRITE
+//=============================================================================
+
+/**
+ * Clones an address space sharing every user frame copy-on-write: writable
+ * pages become read-only in both spaces and get copied on the first write.
+ * PAGE_SHARED pages stay writable and shared.
+ * @param parent Address space to clone
+ * @return The new address space, or 0 if no memory or slots are left
+ */
+address_space_t *paging_fork(address_space_t *parent);
+
+/**
+ * Gives an address space its own writable copy of a copy-on-write page.
+ * If the frame is no longer shared it is just made writable again.
+ * @param space Address space that wants to write
+ * @param virt Virtual address inside the page
+ * @return 0 on success, -1 if the page is not copy-on-write or memory is exhausted
+ */
+int paging_copy_on_write(address_space_t *space, uint64_t virt);
+
+#endif
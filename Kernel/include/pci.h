@@ -0,0 +1,48 @@
+#ifndef PCI_H
+#define PCI_H
+
+#include <stdint.h>
+
+#define PCI_COMMAND 0x04
+#define PCI_CLASS 0x08                      // revision, prog if, subclass, class
+#define PCI_BAR4 0x20
+
+#define PCI_COMMAND_IO 0x1
+#define PCI_COMMAND_BUS_MASTER 0x4
+
+typedef struct {
+	uint8_t bus;
+	uint8_t device;
+	uint8_t function;
+} pci_device_t;
+
+//=============================================================================
+// PCI CONFIGURATION SPACE (MECHANISM #1, PORTS 0xCF8/0xCFC)
+//=============================================================================
+
+/**
+ * Reads a dword from the configuration space of a device.
+ * @param device Device to read
+ * @param offset Dword-aligned register offset
+ * @return The register value
+ */
+uint32_t pci_read(pci_device_t device, uint8_t offset);
+
+/**
+ * Writes a dword to the configuration space of a device.
+ * @param device Device to write
+ * @param offset Dword-aligned register offset
+ * @param value New register value
+ */
+void pci_write(pci_device_t device, uint8_t offset, uint32_t value);
+
+/**
+ * Finds the first device of a class by brute force over every bus/slot.
+ * @param class_code Base class (e.g. 0x01 for mass storage)
+ * @param subclass Subclass (e.g. 0x01 for IDE)
+ * @param device Where to store the device found
+ * @return 0 if found, -1 otherwise
+ */
+int pci_find_class(uint8_t class_code, uint8_t subclass, pci_device_t *device);
+
+#endif
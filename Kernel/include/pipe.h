@@ -0,0 +1,67 @@
+#ifndef PIPE_H
+#define PIPE_H
+
+#include <stdint.h>
+
+#define MAX_PIPES 16
+#define PIPE_PAGES 16                       // capacidad: 64 KiB
+
+// Flags de pipe
+#define PIPE_ZERO_COPY 0x1                  // las paginas enteras del heap se regalan
+
+// Extremos de un pipe
+#define PIPE_READ 0
+#define PIPE_WRITE 1
+
+typedef struct pipe pipe_t;
+
+//=============================================================================
+// PIPES
+//=============================================================================
+
+/**
+ * Creates a pipe with one reader and one writer reference.
+ * @param flags PIPE_* flags
+ * @return The new pipe, or 0 if no slots are left
+ */
+pipe_t *pipe_create(uint64_t flags);
+
+/**
+ * Takes another reference to one end of a pipe (fork, dup).
+ * @param pipe Pipe
+ * @param end PIPE_READ or PIPE_WRITE
+ */
+void pipe_dup(pipe_t *pipe, int end);
+
+/**
+ * Drops a reference to one end of a pipe and wakes whoever waits on the
+ * other one. The pipe is released once both ends are closed.
+ * @param pipe Pipe
+ * @param end PIPE_READ or PIPE_WRITE
+ */
+void pipe_close(pipe_t *pipe, int end);
+
+/**
+ * Reads from a pipe into memory of the current process. Blocks until there
+ * is data or every writer closed. Whole pages written in zero-copy mode are
+ * mapped copy-on-write into page-aligned heap buffers instead of copied.
+ * @param pipe Pipe
+ * @param buffer Destination
+ * @param count Maximum number of bytes to read
+ * @return Number of bytes read (0 once every writer closed)
+ */
+int64_t pipe_read(pipe_t *pipe, void *buffer, uint64_t count);
+
+/**
+ * Writes memory of the current process to a pipe. Blocks until everything
+ * fits. In zero-copy mode, whole page-aligned pages of the heap are given
+ * to the pipe instead of copied: afterwards they read as zeros.
+ * @param pipe Pipe
+ * @param buffer Source
+ * @param count Bytes to write
+ * @return Number of bytes written (less than count if every reader closed),
+ *         or -1 if there were no readers to begin with
+ */
+int64_t pipe_write(pipe_t *pipe, const void *buffer, uint64_t count);
+
+#endif
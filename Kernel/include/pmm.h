@@ -0,0 +1,68 @@
+#ifndef PMM_H
+#define PMM_H
+
+#include <stdint.h>
+
+#define PAGE_SIZE 0x1000
+
+// Pure64 deja mapeada toda la memoria fisica a partir de esta direccion, y el
+// kernel conserva ese direct map en todos los espacios de direcciones.
+#define DIRECT_MAP_BASE 0xFFFF800000000000ULL
+#define P2V(phys) ((void *)((uint64_t)(phys) + DIRECT_MAP_BASE))
+
+// Inversa de P2V; la memoria baja del kernel es identity
+#define V2P(virt) ((uint64_t)(virt) >= DIRECT_MAP_BASE ? (uint64_t)(virt) - DIRECT_MAP_BASE : (uint64_t)(virt))
+
+// Los primeros 16 MiB quedan reservados (kernel, modulos, estructuras de Pure64)
+#define PMM_POOL_START 0x1000000
+
+//=============================================================================
+// PHYSICAL FRAME ALLOCATOR
+//=============================================================================
+
+/**
+ * Initializes the frame pool from the memory size reported by Pure64.
+ */
+void pmm_init(void);
+
+/**
+ * Allocates one 4 KiB physical frame with a reference count of 1.
+ * Its contents are undefined.
+ * @return Physical address of the frame, or 0 if memory is exhausted
+ */
+uint64_t pmm_alloc_frame(void);
+
+/**
+ * Adds a reference to a frame that is about to be shared.
+ * @param frame Physical address of the frame
+ */
+void pmm_ref_frame(uint64_t frame);
+
+/**
+ * Gets the reference count of a frame.
+ * @param frame Physical address of the frame
+ * @return Number of references, 0 for frames outside the pool (never owned)
+ */
+uint64_t pmm_frame_refs(uint64_t frame);
+
+/**
+ * Drops a reference to a frame and returns it to the pool when it reaches 0.
+ * Frames outside the pool are ignored, so mappings of reserved memory can be
+ * released without special cases.
+ * @param frame Physical address of the frame
+ */
+void pmm_free_frame(uint64_t frame);
+
+/**
+ * Gets the end of usable physical memory.
+ * @return First physical address past the last usable byte
+ */
+uint64_t pmm_memory_end(void);
+
+/**
+ * Gets how many frames are currently available.
+ * @return Number of free frames
+ */
+uint64_t pmm_free_frame_count(void);
+
+#endif
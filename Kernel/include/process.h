@@ -0,0 +1,278 @@
+#ifndef PROCESS_H
+#define PROCESS_H
+
+#include <stdint.h>
+#include <registers.h>
+#include <paging.h>
+#include <bmfs.h>
+#include <mmap.h>
+#include <pipe.h>
+
+#define MAX_PROCESSES 64
+#define INIT_MODULE 0                       // modulo del payload que corre como init
+
+// Los segmentos de los ejecutables van debajo del heap; su .bss, el stack y
+// el heap se materializan on demand (primer acceso)
+#define USER_IMAGE_START USER_SPACE_START
+#define USER_IMAGE_END USER_HEAP_START
+#define MAX_BSS_REGIONS 4
+
+#define MAX_THREADS 16                      // threads ademas del principal, por proceso
+#define THREAD_STACK_SIZE 0x40000           // 256 KiB, la pagina de abajo es de guarda
+
+#define MAX_OPEN_FILES 16
+#define FIRST_FILE_FD 3                     // 0, 1 y 2 son la consola
+#define USER_STACK_TOP USER_SPACE_END
+#define USER_STACK_SIZE 0x100000            // 1 MiB
+#define USER_HEAP_START 0x10000000ULL
+#define USER_HEAP_END USER_MMAP_START
+#define USER_MMAP_START 0x20000000ULL       // archivos mapeados con mmap
+#define USER_MMAP_END USER_THREAD_STACKS_START
+#define USER_THREAD_STACKS_END (USER_STACK_TOP - USER_STACK_SIZE)
+#define USER_THREAD_STACKS_START (USER_THREAD_STACKS_END - MAX_THREADS * THREAD_STACK_SIZE)
+
+typedef enum {
+	PROCESS_UNUSED = 0,
+	PROCESS_READY,
+	PROCESS_RUNNING,
+	PROCESS_BLOCKED,
+	PROCESS_ZOMBIE
+} process_state_t;
+
+typedef struct {
+	uint64_t start;
+	uint64_t end;
+	uint64_t flags;                         // PAGE_* con que se mapea cada pagina
+} bss_region_t;
+
+typedef struct {
+	const bmfs_entry_t *file;               // libre si file y pipe son 0
+	uint64_t offset;
+	pipe_t *pipe;
+	int pipe_end;                           // PIPE_READ o PIPE_WRITE
+} open_file_t;
+
+struct wait_queue;
+
+/*
+ * Un thread es una entrada mas de la tabla que comparte el espacio de
+ * direcciones de su lider; la memoria (heap, .bss, mmaps) y los descriptores
+ * son siempre los del lider.
+ */
+typedef struct process {
+	uint64_t pid;                           // del thread; getpid devuelve el del lider
+	struct process *leader;                 // el mismo proceso si no es un thread
+	uint64_t parent_pid;                    // 0 si el padre ya termino
+	process_state_t state;
+	uint64_t rsp;                           // contexto guardado (interrupt_frame_t), en su stack de kernel
+	address_space_t *space;                 // 0 una vez liberado (zombie)
+	uint64_t heap_start;
+	uint64_t heap_end;                      // break actual
+	bss_region_t bss[MAX_BSS_REGIONS];
+	int bss_count;
+	open_file_t files[MAX_OPEN_FILES];      // descriptor FIRST_FILE_FD + i
+	mmap_region_t mmaps[MAX_MMAP_REGIONS];
+	int mmap_count;
+	uint32_t console;                       // consola virtual de fd 1 y 2
+	const registers_t *syscall_frame;       // frame de la syscall en curso
+	address_space_t *exec_space;            // imagen nueva pendiente de un exec
+	uint64_t exec_entry;                    // y su punto de entrada
+	struct process *wait_next;              // siguiente en la wait queue donde duerme
+	struct wait_queue *wait_queue;          // wait queue donde duerme, si alguna
+	uint32_t thread_slots;                  // stacks de threads ocupados (lider)
+	int thread_count;                       // threads sin liberar (lider)
+	int stack_slot;                         // stack del thread
+	uint64_t joining;                       // thread que espera en thread_join
+	int64_t exit_code;
+} process_t;
+
+//=============================================================================
+// PROCESS LIFECYCLE
+//=============================================================================
+
+/**
+ * Gets the process table, indexed by slot.
+ * @return Array of MAX_PROCESSES processes
+ */
+process_t *process_table(void);
+
+/**
+ * Gets the process that owns the memory and descriptors of the running
+ * thread: the running process itself unless it is a thread.
+ * @return The owner of the current address space
+ */
+process_t *process_current(void);
+
+/**
+ * Gets the top of the stack where a process handles its page faults, so
+ * that a fault that blocks (waiting for the disk) keeps its own context.
+ * @param process Process from the table
+ * @return Initial stack pointer for the page fault handler
+ */
+uint64_t process_fault_stack(const process_t *process);
+
+/**
+ * Gets the top of the stack where a process takes its IRQs and syscalls,
+ * which also holds its saved context while it is not running. Userland runs
+ * at CPL0, so without it they would be pushed on the program stack.
+ * @param process Process from the table
+ * @return Initial stack pointer for the IRQ and syscall handlers
+ */
+uint64_t process_kernel_stack(const process_t *process);
+
+/**
+ * Creates the first userland process from the INIT_MODULE module.
+ * It is created again every time it dies because of an exception.
+ * @return The new process, or 0 if it could not be created
+ */
+process_t *process_create_init(void);
+
+/**
+ * Replaces the address space of a process that called exec by its new image
+ * and points its context to the new entry. Called by the scheduler once it no
+ * longer runs on the kernel stack of the process.
+ * @param process Process with a pending exec
+ */
+void process_complete_exec(process_t *process);
+
+/**
+ * Fills an initial context so that resuming it jumps to entry.
+ * @param frame Where to build the context
+ * @param entry First instruction to execute
+ * @param stack Stack pointer at entry
+ */
+void process_build_frame(interrupt_frame_t *frame, uint64_t entry, uint64_t stack);
+
+/**
+ * Marks a process or thread as finished and wakes its parent or joiner.
+ * Terminating a process also terminates all of its threads. Memory is
+ * released by the scheduler once nothing is running on it.
+ * @param process Process to terminate
+ * @param exit_code Value reported to waitpid
+ */
+void process_terminate(process_t *process, int64_t exit_code);
+
+/**
+ * Kills a process because of an unrecoverable exception, together with all
+ * of its threads.
+ * @param process Process or thread that caused the exception
+ */
+void process_kill(process_t *process);
+
+/**
+ * Releases the address space and descriptors of a zombie process, or the
+ * stack of a zombie thread.
+ * @param process Terminated process or thread
+ */
+void process_release(process_t *process);
+
+/**
+ * Resolves a page fault on behalf of the current process: lazily allocates
+ * .bss, heap and stack pages, reads mapped file pages (may block) and breaks
+ * copy-on-write sharing.
+ * @param address Faulting address (CR2)
+ * @param error_code Page fault error code
+ * @return 1 if the fault was resolved, 0 if it is fatal
+ */
+int process_handle_page_fault(uint64_t address, uint64_t error_code);
+
+/**
+ * Makes a page of the current process present (and writable if asked) and
+ * takes a reference to its frame, so it survives while a device uses it.
+ * @param address Virtual address inside the page
+ * @param writable 1 if the page is going to be written
+ * @return Physical address of the frame, to release with pmm_free_frame,
+ *         or 0 if the address is not valid user memory
+ */
+uint64_t process_pin_page(uint64_t address, int writable);
+
+//=============================================================================
+// PROCESS SYSCALLS
+//=============================================================================
+
+/**
+ * Duplicates the current process sharing its memory copy-on-write.
+ * @return Child pid in the parent, 0 in the child, -1 on error
+ */
+int64_t process_fork(void);
+
+/**
+ * Starts an ELF executable module loaded at boot as a new child of the
+ * current process, with its own address space and stack.
+ * @param module Index of the module in the payload
+ * @return Pid of the new process, or -1 on error
+ */
+int64_t process_spawn(uint32_t module);
+
+/**
+ * Starts an ELF executable by name as a new child of the current process:
+ * a payload module with that name (see findModule) or else a file of the
+ * BMFS disk, whose pages are mapped from the block cache.
+ * @param name Module or file name
+ * @return Pid of the new process, or -1 on error
+ */
+int64_t process_spawn_file(const char *name);
+
+/**
+ * Replaces the image of the current process by an ELF executable module.
+ * Keeps the pid and parent. Does not return on success.
+ * @param module Index of the module in the payload
+ * @return -1 on error
+ */
+int64_t process_exec(uint32_t module);
+
+/**
+ * Replaces the image of the current process by an ELF executable found by
+ * name, like process_spawn_file. Keeps the pid and parent. Does not return
+ * on success.
+ * @param name Module or file name
+ * @return -1 on error
+ */
+int64_t process_exec_file(const char *name);
+
+/**
+ * Terminates the current process with all of its threads, or only the
+ * current thread when called from one. Does not return.
+ * @param exit_code Value reported to waitpid
+ */
+void process_exit(int64_t exit_code);
+
+/**
+ * Waits for a child to finish and reaps it.
+ * @param pid Child to wait for, or 0 for any child
+ * @param status Where to store the exit code (may be 0)
+ * @return Pid of the reaped child, or -1 if there are no matching children
+ */
+int64_t process_wait(int64_t pid, int64_t *status);
+
+/**
+ * Moves the heap break. New pages are only allocated when first touched.
+ * @param increment Bytes to grow (or shrink if negative)
+ * @return Previous break, or -1 if the heap cannot grow that much
+ */
+uint64_t process_sbrk(int64_t increment);
+
+//=============================================================================
+// THREAD SYSCALLS
+//=============================================================================
+
+/**
+ * Starts a thread of the current process: it shares the address space,
+ * heap and descriptors, and gets its own stack and saved registers.
+ * The entry function must not return: it ends with process_exit.
+ * @param entry First instruction of the thread
+ * @param arg0 Initial rdi
+ * @param arg1 Initial rsi
+ * @return Id of the new thread, or -1 on error
+ */
+int64_t process_thread_create(uint64_t entry, uint64_t arg0, uint64_t arg1);
+
+/**
+ * Waits for a thread of the current process to finish and reaps it.
+ * @param tid Thread id, as returned by process_thread_create
+ * @param status Where to store its exit code (may be 0)
+ * @return 0 on success, -1 if there is no such thread
+ */
+int64_t process_thread_join(int64_t tid, int64_t *status);
+
+#endif
@@ -22,4 +22,27 @@ typedef struct
     uint64_t r15;
 } registers_t;
 
+// Contexto guardado de un proceso: registros + frame del iretq
+typedef struct
+{
+    registers_t registers;
+    uint64_t rip;
+    uint64_t cs;
+    uint64_t rflags;
+    uint64_t rsp;
+    uint64_t ss;
+} interrupt_frame_t;
+
+// Frame que arma exceptionHandler: registros + codigo de error + frame del iretq
+typedef struct
+{
+    registers_t registers;
+    uint64_t error_code;
+    uint64_t rip;
+    uint64_t cs;
+    uint64_t rflags;
+    uint64_t rsp;
+    uint64_t ss;
+} exception_frame_t;
+
 #endif
\ No newline at end of file
@@ -0,0 +1,73 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include <process.h>
+
+// Procesos bloqueados esperando un mismo evento
+typedef struct wait_queue {
+	process_t *head;
+} wait_queue_t;
+
+/**
+ * Starts running userland processes. Does not return.
+ */
+void scheduler_start(void);
+
+/**
+ * Gets the running process.
+ * @return The running process, or 0 before the scheduler starts
+ */
+process_t *scheduler_current(void);
+
+/**
+ * Blocks the running process and yields the CPU until it is unblocked.
+ * Callers must re-check their wait condition after it returns.
+ */
+void scheduler_block(void);
+
+/**
+ * Blocks the running process on a wait queue until it is woken up.
+ * Callers must re-check their wait condition after it returns.
+ * @param queue Queue to sleep on
+ */
+void scheduler_wait(wait_queue_t *queue);
+
+/**
+ * Makes every process sleeping on a wait queue runnable again.
+ * Safe to call from interrupt handlers.
+ * @param queue Queue to wake up
+ */
+void scheduler_wake_all(wait_queue_t *queue);
+
+/**
+ * Makes the process that has been sleeping the longest on a wait queue
+ * runnable again.
+ * @param queue Queue to wake up
+ * @return 1 if a process was woken, 0 if the queue was empty
+ */
+int scheduler_wake_one(wait_queue_t *queue);
+
+/**
+ * Makes a blocked process runnable again, taking it out of the wait queue
+ * it sleeps on if any.
+ * @param process Process to wake up
+ */
+void scheduler_unblock(process_t *process);
+
+/**
+ * Saves the current context and picks the next process (round robin).
+ * Called from the timer and yield interrupts on the scheduler stack.
+ * @param rsp Saved context of the running process
+ * @return Context to resume
+ */
+uint64_t schedule(uint64_t rsp);
+
+/**
+ * Kills the running process after a fatal exception.
+ * Called from the exception handlers on the scheduler stack.
+ * @return Context to resume
+ */
+uint64_t killCurrentProcess(void);
+
+#endif
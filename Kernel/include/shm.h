@@ -0,0 +1,37 @@
+#ifndef SHM_H
+#define SHM_H
+
+#include <stdint.h>
+
+#define MAX_SHM_REGIONS 16
+#define SHM_MAX_PAGES 512                   // la lista de frames ocupa una pagina: 2 MiB
+
+//=============================================================================
+// SHARED MEMORY
+//=============================================================================
+
+/**
+ * Creates a zeroed shared memory region. Any process can map it by id
+ * until it is destroyed.
+ * @param size Bytes (rounded up to pages, at most 2 MiB)
+ * @return Region id, or -1 if no memory or slots are left
+ */
+int64_t shm_create(uint64_t size);
+
+/**
+ * Maps a shared memory region in the mmap area of the current process.
+ * Unmapped with file_unmap like any other mapping.
+ * @param id Region id
+ * @return Start of the mapping, or 0 on error
+ */
+uint64_t shm_map(int64_t id);
+
+/**
+ * Destroys a shared memory region. Processes that have it mapped keep
+ * their pages until they unmap them or terminate.
+ * @param id Region id
+ * @return 0 on success, -1 if the id is not valid
+ */
+int64_t shm_destroy(int64_t id);
+
+#endif
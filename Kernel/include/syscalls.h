@@ -2,9 +2,83 @@
 #define SYSCALLS_H
 
 #include <stdint.h>
+#include <bootTrace.h>
+#include <videoDriver.h>
 
 uint64_t sys_read(uint64_t fd, char *buf, uint64_t count);
 
 uint64_t sys_write(uint64_t fd, const char *buf, uint64_t count);
 
+uint64_t sys_exit(int64_t code);
+
+int64_t sys_fork(void);
+
+uint64_t sys_getpid(void);
+
+int64_t sys_waitpid(int64_t pid, int64_t *status);
+
+uint64_t sys_yield(void);
+
+uint64_t sys_sbrk(int64_t increment);
+
+int64_t sys_spawn(uint64_t module);
+
+int64_t sys_exec(uint64_t module);
+
+int64_t sys_open(const char *name);
+
+int64_t sys_close(uint64_t fd);
+
+int64_t sys_seek(uint64_t fd, uint64_t offset);
+
+int64_t sys_fsize(uint64_t fd);
+
+int64_t sys_spawn_file(const char *name);
+
+int64_t sys_aio_read(uint64_t fd, void *buf, uint64_t count);
+
+int64_t sys_aio_write(uint64_t fd, const void *buf, uint64_t count);
+
+int64_t sys_aio_wait(int64_t id);
+
+void *sys_mmap(uint64_t fd, uint64_t offset, uint64_t length, uint64_t flags);
+
+int64_t sys_munmap(void *address);
+
+uint64_t sys_boot_trace(boot_trace_record_t *buffer, uint64_t max);
+
+int64_t sys_pipe(int64_t *fds, uint64_t flags);
+
+uint64_t sys_clock(void);
+
+int64_t sys_shm_create(uint64_t size);
+
+void *sys_shm_map(int64_t id);
+
+int64_t sys_shm_destroy(int64_t id);
+
+int64_t sys_futex_wait(uint32_t *address, uint32_t expected);
+
+int64_t sys_futex_wake(uint32_t *address, uint64_t count);
+
+int64_t sys_thread_create(uint64_t entry, uint64_t arg0, uint64_t arg1);
+
+int64_t sys_thread_join(int64_t tid, int64_t *status);
+
+uint64_t sys_gettid(void);
+
+void *sys_fb_map(framebuffer_info_t *info, uint64_t flags);
+
+uint64_t sys_fb_present(const uint8_t *buffer);
+
+uint64_t sys_gfx_submit(const gfx_command_t *commands, uint64_t count);
+
+int64_t sys_video_mode(uint64_t width, uint64_t height, uint64_t bpp);
+
+int64_t sys_fb_flip(uint64_t page);
+
+int64_t sys_set_console(uint64_t console);
+
+int64_t sys_exec_file(const char *name);
+
 #endif
\ No newline at end of file
@@ -1,8 +1,12 @@
 #ifndef _TIME_H_
 #define _TIME_H_
 
+#include <stdint.h>
+
 void timer_handler();
 int ticks_elapsed();
 int seconds_elapsed();
+uint64_t cycles_to_microseconds(uint64_t cycles);
+uint64_t microseconds_elapsed();
 
 #endif
@@ -7,10 +7,53 @@
 #define CHAR_BIT_WIDTH 8
 #define CHAR_BIT_HEIGHT 16
 
-// Text buffer dimensions for 4px font size
+// Text buffer dimensions for 4px font size (the history is SCREEN_TEXT_BUFFER_HEIGHT
+// lines until video_init gives it frames)
 #define SCREEN_TEXT_BUFFER_WIDTH 200  // 800px width / 4px font size
 #define SCREEN_TEXT_BUFFER_HEIGHT 150 // 600px height / 4px font size
 
+// Virtual consoles, switched with Alt+F1 to Alt+F4
+#define MAX_CONSOLES 4
+
+// sys_fb_map flags
+#define FB_MAP_BACK_BUFFER 0x1   // private buffer with the same layout, shown with sys_fb_present
+
+// Geometry and pixel format of the linear framebuffer
+typedef struct {
+    uint64_t address;       // physical address
+    uint32_t width;
+    uint32_t height;
+    uint32_t pitch;         // bytes per line
+    uint32_t bpp;
+    uint32_t red_mask;
+    uint32_t green_mask;
+    uint32_t blue_mask;
+    uint32_t pages;         // screens that fit in video memory, one after the other
+} framebuffer_info_t;
+
+// sys_gfx_submit command types
+#define GFX_FILL_RECT 0         // rectangle of color
+#define GFX_BLIT 1              // bitmap of 0xRRGGBB pixels
+#define GFX_GLYPHS 2            // run of font characters
+#define GFX_LINE 3              // line from (x, y) to (x2, y2)
+#define GFX_COPY_RECT 4         // moves a rectangle of the screen to (x, y)
+
+// One drawing command; coordinates may fall outside the screen (clipped)
+typedef struct {
+    uint32_t type;          // GFX_*
+    uint32_t color;         // 0xRRGGBB
+    int32_t x;
+    int32_t y;
+    uint32_t width;
+    uint32_t height;
+    union {
+        struct { int32_t x2, y2; } line;
+        struct { int32_t src_x, src_y; } copy;
+        struct { const uint32_t *pixels; uint32_t stride; } blit;                  // stride in pixels
+        struct { const char *text; uint32_t length; uint32_t scale; } glyphs;     // scale 0: current font size
+    } args;
+} gfx_command_t;
+
 
 //=============================================================================
 // BASIC DRAWING FUNCTIONS
@@ -107,6 +150,50 @@ void write_to_video_text_buffer(const char* data, uint32_t data_len, uint32_t he
  */
 void clear_video_text_buffer(void);
 
+/**
+ * Pages the text view through the scrollback history. Paging down to the
+ * newest lines makes the view follow the cursor again; while paged back,
+ * new output is kept in the history without being drawn.
+ * @param pages Screens to move, negative to go back in the history
+ */
+void scroll_text_view(int32_t pages);
+
+//=============================================================================
+// VIRTUAL CONSOLES
+//=============================================================================
+
+/**
+ * Writes text data to one virtual console, like write_to_video_text_buffer.
+ * Only the active console is drawn; the others keep the text until shown.
+ * @param console Console index (0 to MAX_CONSOLES - 1)
+ * @param data Text data to write
+ * @param data_len Length of data in bytes
+ * @param hexColor RGB color for the text (0xRRGGBB)
+ */
+void write_to_console(uint32_t console, const char* data, uint32_t data_len, uint32_t hexColor);
+
+/**
+ * Shows another virtual console. The screen being hidden is saved to a
+ * per-console cache, and the new console is repainted from its own cache
+ * when it has one, drawing only the lines written while it was hidden.
+ * @param console Console index
+ * @return 0 on success, -1 if the console does not exist or has no memory
+ */
+int switch_console(uint32_t console);
+
+/**
+ * Tells whether a virtual console can be used.
+ * @param console Console index
+ * @return 1 if it got memory for its text, 0 otherwise
+ */
+int console_available(uint32_t console);
+
+/**
+ * Gets the console being shown.
+ * @return Index of the active console
+ */
+uint32_t active_console(void);
+
 //=============================================================================
 // SCREEN MANAGEMENT FUNCTIONS
 //=============================================================================
@@ -123,4 +210,63 @@ void set_font_size(uint32_t fontSize);
  */
 void clear_screen(uint32_t clearColor);
 
+//=============================================================================
+// DIRECT FRAMEBUFFER ACCESS
+//=============================================================================
+
+/**
+ * Gets the geometry and pixel format of the framebuffer.
+ * @param info Where to store it
+ */
+void get_framebuffer_info(framebuffer_info_t *info);
+
+/**
+ * Copies a whole back buffer, laid out like the framebuffer (same pitch
+ * and pixel format), to the screen.
+ * @param buffer Back buffer of pitch * height bytes
+ */
+void present_framebuffer(const uint8_t *buffer);
+
+/**
+ * Shows one page of video memory: page N starts N * height lines after
+ * the framebuffer address. Flipping between pages needs no copy.
+ * @param page Page, below the pages reported by get_framebuffer_info
+ * @return 0 on success, -1 if the page does not exist
+ */
+int show_framebuffer_page(uint32_t page);
+
+//=============================================================================
+// VIDEO MODE
+//=============================================================================
+
+/**
+ * Detects the Bochs VBE extensions (QEMU std VGA). With them the text
+ * console scrolls by panning over video memory instead of redrawing.
+ */
+void video_init(void);
+
+/**
+ * Switches the video mode at runtime and redraws the text console.
+ * Needs the Bochs VBE extensions. Existing framebuffer mappings keep the
+ * old geometry.
+ * @param width Width in pixels
+ * @param height Height in pixels
+ * @param bpp Bits per pixel (15, 16, 24 or 32)
+ * @return 0 on success, -1 if the mode is not supported
+ */
+int set_video_mode(uint32_t width, uint32_t height, uint32_t bpp);
+
+//=============================================================================
+// GRAPHICS COMMANDS
+//=============================================================================
+
+/**
+ * Runs a batch of drawing commands in order, clipped to the screen. Fills,
+ * glyphs and blits are drawn one row span at a time instead of per pixel.
+ * @param commands Commands to run
+ * @param count Number of commands
+ * @return Number of commands run (stops at the first of unknown type)
+ */
+uint64_t execute_gfx_commands(const gfx_command_t *commands, uint64_t count);
+
 #endif
@@ -0,0 +1,78 @@
+#include <stdint.h>
+#include <futex.h>
+#include <process.h>
+#include <scheduler.h>
+#include <paging.h>
+#include <pmm.h>
+
+/*
+ * Cada direccion con procesos esperando ocupa una entrada con su wait queue.
+ * Con el kernel no expropiativo comparar el valor y dormir es atomico: nadie
+ * puede cambiarlo ni despertar entre medio.
+ */
+typedef struct {
+	uint64_t key;                           // direccion fisica
+	wait_queue_t queue;                     // vacia si la entrada esta libre
+} futex_t;
+
+static futex_t futexes[MAX_FUTEXES];
+
+// Se rompe el copy-on-write ya: una escritura posterior cambiaria el frame
+static uint64_t futex_key(uint32_t *address) {
+	if ((uint64_t)address % sizeof(uint32_t) != 0)
+		return 0;
+
+	uint64_t frame = process_pin_page((uint64_t)address, 1);
+	if (frame == 0)
+		return 0;
+	pmm_free_frame(frame);
+	return frame + (uint64_t)address % PAGE_SIZE;
+}
+
+static futex_t *find_futex(uint64_t key) {
+	for (int i = 0; i < MAX_FUTEXES; i++)
+		if (futexes[i].key == key && futexes[i].queue.head != 0)
+			return &futexes[i];
+	return 0;
+}
+
+// Una entrada sin nadie esperando esta libre
+static futex_t *alloc_futex(uint64_t key) {
+	for (int i = 0; i < MAX_FUTEXES; i++) {
+		if (futexes[i].queue.head == 0) {
+			futexes[i].key = key;
+			return &futexes[i];
+		}
+	}
+	return 0;
+}
+
+int64_t futex_wait(uint32_t *address, uint32_t expected) {
+	uint64_t key = futex_key(address);
+	if (key == 0 || *(uint32_t *)P2V(key) != expected)
+		return -1;
+
+	futex_t *futex = find_futex(key);
+	if (futex == 0)
+		futex = alloc_futex(key);
+	if (futex == 0)
+		return -1;
+
+	scheduler_wait(&futex->queue);
+	return 0;
+}
+
+int64_t futex_wake(uint32_t *address, uint64_t count) {
+	uint64_t key = futex_key(address);
+	if (key == 0)
+		return -1;
+
+	futex_t *futex = find_futex(key);
+	if (futex == 0)
+		return 0;
+
+	int64_t woken = 0;
+	while ((uint64_t)woken < count && scheduler_wake_one(&futex->queue))
+		woken++;
+	return woken;
+}
@@ -0,0 +1,256 @@
+#include <stdint.h>
+#include <pipe.h>
+#include <process.h>
+#include <scheduler.h>
+#include <paging.h>
+#include <pmm.h>
+#include <lib.h>
+
+/*
+ * El buffer es un anillo de paginas: el escritor llena la ultima y el lector
+ * vacia la primera. head solo lo mueve el lector y tail el escritor, asi que
+ * no hace falta ningun lock (y con el kernel no expropiativo tampoco hay
+ * carreras entre varios lectores o escritores mientras no se bloqueen).
+ * Toda copia pasa por paginas fijadas con process_pin_page: nunca hay un
+ * page fault (que podria bloquearse) con el anillo a medio actualizar.
+ */
+typedef struct {
+	uint64_t frame;                         // 0 si el slot esta libre
+	uint16_t start;                         // proximo byte a leer
+	uint16_t end;                           // proximo byte a escribir
+} pipe_slot_t;
+
+struct pipe {
+	pipe_slot_t slots[PIPE_PAGES];
+	uint64_t head;                          // slot a leer (contador que no vuelve a 0)
+	uint64_t tail;                          // slot siguiente al ultimo escrito
+	uint64_t spare;                         // frame vaciado, para no volver al PMM
+	uint64_t flags;
+	uint32_t readers;
+	uint32_t writers;
+	wait_queue_t readable;
+	wait_queue_t writable;
+	uint8_t in_use;
+};
+
+static pipe_t pipes[MAX_PIPES];
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+static pipe_slot_t *slot_at(pipe_t *pipe, uint64_t index) {
+	return &pipe->slots[index % PIPE_PAGES];
+}
+
+static int is_full(pipe_t *pipe) {
+	return pipe->tail - pipe->head == PIPE_PAGES && slot_at(pipe, pipe->tail - 1)->end == PAGE_SIZE;
+}
+
+static void release_frame(pipe_t *pipe, uint64_t frame) {
+	if (pipe->spare == 0 && pmm_frame_refs(frame) == 1)
+		pipe->spare = frame;
+	else
+		pmm_free_frame(frame);
+}
+
+static void pop_slot(pipe_t *pipe) {
+	slot_at(pipe, pipe->head)->frame = 0;
+	pipe->head++;
+}
+
+static pipe_slot_t *push_slot(pipe_t *pipe, uint64_t frame, uint16_t end) {
+	pipe_slot_t *slot = slot_at(pipe, pipe->tail++);
+	slot->frame = frame;
+	slot->start = 0;
+	slot->end = end;
+	return slot;
+}
+
+// Las paginas regaladas se materializan de nuevo (en cero) al tocarlas
+static int in_heap(const process_t *process, uint64_t address, uint64_t remaining) {
+	return address % PAGE_SIZE == 0 && remaining >= PAGE_SIZE
+			&& address >= process->heap_start && address + PAGE_SIZE <= process->heap_end;
+}
+
+pipe_t *pipe_create(uint64_t flags) {
+	for (int i = 0; i < MAX_PIPES; i++) {
+		if (!pipes[i].in_use) {
+			memset(&pipes[i], 0, sizeof(pipe_t));
+			pipes[i].in_use = 1;
+			pipes[i].flags = flags;
+			pipes[i].readers = 1;
+			pipes[i].writers = 1;
+			return &pipes[i];
+		}
+	}
+	return 0;
+}
+
+void pipe_dup(pipe_t *pipe, int end) {
+	if (end == PIPE_READ)
+		pipe->readers++;
+	else
+		pipe->writers++;
+}
+
+void pipe_close(pipe_t *pipe, int end) {
+	if (end == PIPE_READ) {
+		pipe->readers--;
+		scheduler_wake_all(&pipe->writable);
+	} else {
+		pipe->writers--;
+		scheduler_wake_all(&pipe->readable);
+	}
+
+	if (pipe->readers != 0 || pipe->writers != 0)
+		return;
+
+	while (pipe->head != pipe->tail) {
+		pmm_free_frame(slot_at(pipe, pipe->head)->frame);
+		pop_slot(pipe);
+	}
+	if (pipe->spare != 0)
+		pmm_free_frame(pipe->spare);
+	pipe->in_use = 0;
+}
+
+//=============================================================================
+// READING
+//=============================================================================
+
+// Una pagina entera pasa al lector copy-on-write: la comparten hasta que uno escriba
+static int take_page(pipe_t *pipe, process_t *process, uint64_t address) {
+	pipe_slot_t *slot = slot_at(pipe, pipe->head);
+	uint64_t old = paging_unmap(process->space, address);
+
+	if (paging_map(process->space, address, slot->frame, PAGE_USER | PAGE_COW) != 0) {
+		if (old != 0)
+			paging_map(process->space, address, old, PAGE_USER | PAGE_WRITABLE);
+		return 0;
+	}
+	if (old != 0)
+		pmm_free_frame(old);
+	pop_slot(pipe);
+	return 1;
+}
+
+static uint64_t copy_out(pipe_t *pipe, uint64_t address, uint64_t remaining) {
+	uint64_t frame = process_pin_page(address, 1);
+	if (frame == 0)
+		return 0;
+
+	// Fijar la pagina pudo bloquear: otro lector pudo vaciar el pipe
+	uint64_t copied = 0;
+	if (pipe->head != pipe->tail) {
+		pipe_slot_t *slot = slot_at(pipe, pipe->head);
+		copied = MIN(MIN((uint64_t)(slot->end - slot->start), PAGE_SIZE - address % PAGE_SIZE), remaining);
+
+		memcpy((uint8_t *)P2V(frame) + address % PAGE_SIZE, (uint8_t *)P2V(slot->frame) + slot->start, copied);
+		slot->start += copied;
+		if (slot->start == slot->end) {
+			release_frame(pipe, slot->frame);
+			pop_slot(pipe);
+		}
+	}
+	pmm_free_frame(frame);
+	return copied;
+}
+
+int64_t pipe_read(pipe_t *pipe, void *buffer, uint64_t count) {
+	process_t *process = process_current();
+	uint64_t done = 0;
+
+	while (pipe->head == pipe->tail) {
+		if (pipe->writers == 0 || count == 0)
+			return 0;
+		scheduler_wait(&pipe->readable);
+	}
+
+	while (done < count && pipe->head != pipe->tail) {
+		uint64_t address = (uint64_t)buffer + done;
+		pipe_slot_t *slot = slot_at(pipe, pipe->head);
+
+		if ((pipe->flags & PIPE_ZERO_COPY) && slot->start == 0 && slot->end == PAGE_SIZE
+				&& in_heap(process, address, count - done) && take_page(pipe, process, address)) {
+			done += PAGE_SIZE;
+			continue;
+		}
+
+		uint64_t copied = copy_out(pipe, address, count - done);
+		if (copied == 0)
+			break;
+		done += copied;
+	}
+
+	scheduler_wake_all(&pipe->writable);
+	return done > 0 ? (int64_t)done : -1;
+}
+
+//=============================================================================
+// WRITING
+//=============================================================================
+
+// La pagina sale del espacio del escritor y pasa a ser un slot lleno
+static int give_page(pipe_t *pipe, process_t *process, uint64_t address) {
+	uint64_t frame = paging_unmap(process->space, address);
+	if (frame == 0)
+		return 0;                           // nunca se toco: se copian ceros
+	push_slot(pipe, frame, PAGE_SIZE);
+	return 1;
+}
+
+static uint64_t copy_in(pipe_t *pipe, uint64_t address, uint64_t remaining) {
+	uint64_t frame = process_pin_page(address, 0);
+	if (frame == 0)
+		return 0;
+
+	// Se agrega a la ultima pagina si le queda lugar; si no, se abre otra
+	pipe_slot_t *slot = 0;
+	if (pipe->tail != pipe->head && slot_at(pipe, pipe->tail - 1)->end < PAGE_SIZE) {
+		slot = slot_at(pipe, pipe->tail - 1);
+	} else if (pipe->tail - pipe->head < PIPE_PAGES) {
+		uint64_t page = pipe->spare != 0 ? pipe->spare : pmm_alloc_frame();
+		pipe->spare = 0;
+		if (page != 0)
+			slot = push_slot(pipe, page, 0);
+	}
+
+	uint64_t copied = 0;
+	if (slot != 0) {
+		copied = MIN(MIN(PAGE_SIZE - slot->end, PAGE_SIZE - address % PAGE_SIZE), remaining);
+		memcpy((uint8_t *)P2V(slot->frame) + slot->end, (uint8_t *)P2V(frame) + address % PAGE_SIZE, copied);
+		slot->end += copied;
+	}
+	pmm_free_frame(frame);
+	return copied;
+}
+
+int64_t pipe_write(pipe_t *pipe, const void *buffer, uint64_t count) {
+	process_t *process = process_current();
+	uint64_t done = 0;
+
+	if (pipe->readers == 0)
+		return -1;
+
+	while (done < count && pipe->readers != 0) {
+		uint64_t address = (uint64_t)buffer + done;
+
+		if (is_full(pipe)) {
+			scheduler_wait(&pipe->writable);
+			continue;
+		}
+
+		uint64_t written = 0;
+		if ((pipe->flags & PIPE_ZERO_COPY) && pipe->tail - pipe->head < PIPE_PAGES
+				&& in_heap(process, address, count - done) && give_page(pipe, process, address))
+			written = PAGE_SIZE;
+		else
+			written = copy_in(pipe, address, count - done);
+
+		// Direccion invalida o sin memoria
+		if (written == 0)
+			break;
+		done += written;
+		scheduler_wake_all(&pipe->readable);
+	}
+	return done;
+}
@@ -0,0 +1,75 @@
+#include <stdint.h>
+#include <shm.h>
+#include <mmap.h>
+#include <process.h>
+#include <scheduler.h>
+#include <pmm.h>
+#include <lib.h>
+
+/*
+ * La region guarda una referencia a cada frame y cada mapeo la suya, asi
+ * que destruirla no le saca la memoria a quien todavia la tiene mapeada.
+ */
+typedef struct {
+	uint64_t *frames;                       // una pagina del PMM
+	uint64_t pages;                         // 0 si el slot esta libre
+} shm_region_t;
+
+static shm_region_t regions[MAX_SHM_REGIONS];
+
+static shm_region_t *get_region(int64_t id) {
+	if (id < 0 || id >= MAX_SHM_REGIONS || regions[id].pages == 0)
+		return 0;
+	return &regions[id];
+}
+
+static void release_region(shm_region_t *region, uint64_t pages) {
+	for (uint64_t i = 0; i < pages; i++)
+		pmm_free_frame(region->frames[i]);
+	pmm_free_frame(V2P(region->frames));
+	region->pages = 0;
+}
+
+int64_t shm_create(uint64_t size) {
+	uint64_t pages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+	if (pages == 0 || pages > SHM_MAX_PAGES)
+		return -1;
+
+	for (int64_t id = 0; id < MAX_SHM_REGIONS; id++) {
+		shm_region_t *region = &regions[id];
+		if (region->pages != 0)
+			continue;
+
+		uint64_t list = pmm_alloc_frame();
+		if (list == 0)
+			return -1;
+		region->frames = (uint64_t *)P2V(list);
+
+		for (uint64_t i = 0; i < pages; i++) {
+			uint64_t frame = pmm_alloc_frame();
+			if (frame == 0) {
+				release_region(region, i);
+				return -1;
+			}
+			memset(P2V(frame), 0, PAGE_SIZE);
+			region->frames[i] = frame;
+		}
+		region->pages = pages;
+		return id;
+	}
+	return -1;
+}
+
+uint64_t shm_map(int64_t id) {
+	shm_region_t *region = get_region(id);
+	return region != 0 ? mmap_create_shared(process_current(), region->frames, region->pages) : 0;
+}
+
+int64_t shm_destroy(int64_t id) {
+	shm_region_t *region = get_region(id);
+	if (region == 0)
+		return -1;
+
+	release_region(region, region->pages);
+	return 0;
+}
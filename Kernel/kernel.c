@@ -7,6 +7,15 @@
 #include <idtLoader.h>
 #include <syscalls.h>
 #include <registers.h>
+#include <pmm.h>
+#include <paging.h>
+#include <scheduler.h>
+#include <process.h>
+#include <gdtLoader.h>
+#include <ataDriver.h>
+#include <blockCache.h>
+#include <bmfs.h>
+#include <bootTrace.h>
 
 extern uint8_t text;
 extern uint8_t rodata;
@@ -17,9 +26,9 @@ extern uint8_t endOfKernel;
 
 static const uint64_t PageSize = 0x1000;
 
-extern void *USERLAND_CODE_ADDRESS;
-extern void *USERLAND_DATA_ADDRESS;
-extern void start_userland();
+#ifdef BOOT_BENCHMARK
+#define QEMU_DEBUG_EXIT_PORT 0xF4
+#endif
 
 typedef int (*EntryPoint)();
 
@@ -40,19 +49,40 @@ void * getStackBase()
 
 void * initializeKernelBinary()
 {
-	void * moduleAddresses[] = {
-		USERLAND_CODE_ADDRESS,
-		USERLAND_DATA_ADDRESS
-	};
-	loadModules(&endOfKernelBinary, moduleAddresses);
+	uint64_t start = readTSC();
+
 	clearBSS(&bss, &endOfKernel - &bss);
+	boot_trace_init();
+	boot_trace_at("initializeKernelBinary", start);
+	loadModules(&endOfKernelBinary);
+	boot_trace("modules loaded");
 	return getStackBase();
 }
 
 int main()
 {	
+	load_gdt();
 	load_idt();
-	start_userland();
+	boot_trace("load_idt");
+	pmm_init();
+	paging_init();
+	boot_trace("paging");
+	video_init();
+	cache_init();
+	// El directorio se lee por PIO; despues todo va por DMA (IRQ 14)
+	if (ata_init() == 0) {
+		bmfs_init();
+		ata_dma_init();
+	}
+	boot_trace("disk");
+	process_create_init();
+	boot_trace("start_userland");
+	boot_trace_print();
+#ifdef BOOT_BENCHMARK
+	// Con -device isa-debug-exit QEMU termina aca: Image/bootBenchmark.sh mide el boot
+	outb(QEMU_DEBUG_EXIT_PORT, 0);
+#endif
+	scheduler_start();
 	return 0;
 }
 	
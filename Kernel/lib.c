@@ -48,3 +48,40 @@ void * memcpy(void * destination, const void * source, uint64_t length)
 
 	return destination;
 }
+
+void * memmove(void * destination, const void * source, uint64_t length)
+{
+	uint8_t * d = (uint8_t*)destination;
+	const uint8_t * s = (const uint8_t*)source;
+
+	// Hacia adelante no pisa lo que falta copiar si el destino esta antes
+	if (d <= s || d >= s + length)
+		return memcpy(destination, source, length);
+
+	while (length--)
+		d[length] = s[length];
+
+	return destination;
+}
+
+int strncmp(const char * first, const char * second, uint64_t length)
+{
+	for (; length > 0; length--, first++, second++) {
+		if (*first != *second)
+			return (uint8_t)*first - (uint8_t)*second;
+		if (*first == 0)
+			return 0;
+	}
+	return 0;
+}
+
+int memcmp(const void * first, const void * second, uint64_t length)
+{
+	const uint8_t * a = (const uint8_t*)first;
+	const uint8_t * b = (const uint8_t*)second;
+
+	for (uint64_t i = 0; i < length; i++)
+		if (a[i] != b[i])
+			return a[i] - b[i];
+	return 0;
+}
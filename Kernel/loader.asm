@@ -1,8 +1,12 @@
 global loader
+global loaderTSC
 extern main
 extern initializeKernelBinary
 
 loader:
+	rdtsc					; Boot trace: el .bss todavia no esta limpio
+	mov [loaderTSC], eax
+	mov [loaderTSC + 4], edx
 	call initializeKernelBinary	; Set up the kernel binary, and get thet stack address
 	mov rsp, rax				; Set up the stack with the returned address
 	call main
@@ -10,3 +14,7 @@ hang:
 	cli
 	hlt	; halt machine should kernel return
 	jmp hang
+
+section .data
+loaderTSC:
+	dq 0
@@ -0,0 +1,68 @@
+#include <stdint.h>
+#include <lz4.h>
+#include <lib.h>
+
+#define MIN_MATCH 4
+
+// Las longitudes de 15 siguen en bytes extra mientras valgan 255
+static int readLength(const uint8_t **in, const uint8_t *end, uint64_t *length)
+{
+	uint8_t byte;
+
+	if (*length != 15)
+		return 0;
+	do {
+		if (*in >= end)
+			return -1;
+		byte = *(*in)++;
+		*length += byte;
+	} while (byte == 255);
+	return 0;
+}
+
+int lz4_decompress(const void *source, uint64_t sourceSize, void *destination, uint64_t size)
+{
+	const uint8_t *in = source;
+	const uint8_t *inEnd = in + sourceSize;
+	uint8_t *out = destination;
+	uint8_t *outEnd = out + size;
+
+	while (in < inEnd) {
+		uint8_t token = *in++;
+		uint64_t literals = token >> 4;
+
+		if (readLength(&in, inEnd, &literals) != 0 || literals > (uint64_t)(inEnd - in) || literals > (uint64_t)(outEnd - out))
+			return -1;
+		memcpy(out, in, literals);
+		in += literals;
+		out += literals;
+
+		// La ultima secuencia tiene solo literales
+		if (in == inEnd)
+			break;
+
+		if (inEnd - in < 2)
+			return -1;
+		uint64_t offset = in[0] | (in[1] << 8);
+		uint64_t length = token & 0xF;
+		in += 2;
+
+		if (offset == 0 || offset > (uint64_t)(out - (uint8_t *)destination) || readLength(&in, inEnd, &length) != 0)
+			return -1;
+		length += MIN_MATCH;
+		if (length > (uint64_t)(outEnd - out))
+			return -1;
+
+		// Si la copia se solapa con lo que escribe (runs) va de a un byte
+		const uint8_t *match = out - offset;
+		if (offset >= length) {
+			memcpy(out, match, length);
+			out += length;
+		} else {
+			while (length--)
+				*out++ = *match++;
+		}
+	}
+
+	return out == outEnd ? 0 : -1;
+}
@@ -0,0 +1,215 @@
+#include <stdint.h>
+#include <mmap.h>
+#include <process.h>
+#include <paging.h>
+#include <pmm.h>
+#include <lib.h>
+
+#define PAGE_ALIGN_DOWN(x) ((x) & ~(PAGE_SIZE - 1))
+#define PAGE_ALIGN_UP(x) (((x) + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1))
+#define MMAP_ALIGN_UP(x) (((x) + MMAP_ALIGNMENT - 1) & ~(MMAP_ALIGNMENT - 1))
+
+static int overlaps(const process_t *process, uint64_t start, uint64_t end) {
+	for (int i = 0; i < process->mmap_count; i++)
+		if (start < process->mmaps[i].end && process->mmaps[i].start < end)
+			return 1;
+	return 0;
+}
+
+/*
+ * Cada mapeo arranca alineado a 2 MiB: un bloque de BMFS cae entero en una
+ * tabla de paginas. Se toma el primer hueco libre del area de mmap.
+ */
+static uint64_t find_space(const process_t *process, uint64_t length) {
+	uint64_t start = USER_MMAP_START;
+
+	while (start + length <= USER_MMAP_END) {
+		if (!overlaps(process, start, start + length))
+			return start;
+		start += MMAP_ALIGNMENT;
+	}
+	return 0;
+}
+
+uint64_t mmap_create(process_t *process, const bmfs_entry_t *file, uint64_t offset, uint64_t length, uint64_t flags) {
+	if (process->mmap_count == MAX_MMAP_REGIONS || offset % PAGE_SIZE != 0 || offset >= file->size || length == 0)
+		return 0;
+
+	if (length > file->size - offset)
+		length = file->size - offset;
+	length = PAGE_ALIGN_UP(length);
+
+	uint64_t start = find_space(process, MMAP_ALIGN_UP(length));
+	if (start == 0)
+		return 0;
+
+	// Los frames del cache se comparten: escribir solo rompe el copy-on-write
+	mmap_region_t *region = &process->mmaps[process->mmap_count++];
+	region->start = start;
+	region->end = start + length;
+	region->file = file;
+	region->offset = offset;
+	region->flags = PAGE_USER | PAGE_NX | (flags & MMAP_WRITABLE ? PAGE_COW : 0);
+	region->anonymous = 0;
+	return start;
+}
+
+// Reserva lugar para una region sin archivo; queda registrada al confirmarla
+static mmap_region_t *new_region(process_t *process, uint64_t length, uint64_t flags) {
+	if (process->mmap_count == MAX_MMAP_REGIONS || length == 0)
+		return 0;
+
+	uint64_t start = find_space(process, MMAP_ALIGN_UP(length));
+	if (start == 0)
+		return 0;
+
+	mmap_region_t *region = &process->mmaps[process->mmap_count];
+	region->start = start;
+	region->end = start + length;
+	region->file = 0;
+	region->offset = 0;
+	region->flags = flags;
+	region->anonymous = 0;
+	return region;
+}
+
+// Las paginas se mapean ya: no hay nada que traer on demand
+static uint64_t map_frames(process_t *process, mmap_region_t *region, const uint64_t *frames, uint64_t first_frame) {
+	for (uint64_t page = region->start; page < region->end; page += PAGE_SIZE) {
+		uint64_t i = (page - region->start) / PAGE_SIZE;
+		uint64_t frame = frames != 0 ? frames[i] : first_frame + i * PAGE_SIZE;
+
+		if (paging_map(process->space, page, frame, region->flags) != 0) {
+			while (page > region->start) {
+				page -= PAGE_SIZE;
+				pmm_free_frame(paging_unmap(process->space, page));
+			}
+			return 0;
+		}
+		pmm_ref_frame(frame);
+	}
+
+	process->mmap_count++;
+	return region->start;
+}
+
+uint64_t mmap_create_shared(process_t *process, const uint64_t *frames, uint64_t pages) {
+	mmap_region_t *region = new_region(process, pages * PAGE_SIZE, PAGE_USER | PAGE_WRITABLE | PAGE_SHARED | PAGE_NX);
+	return region != 0 ? map_frames(process, region, frames, 0) : 0;
+}
+
+// Fuera del pool las referencias no cuentan: liberarlas despues no hace nada
+uint64_t mmap_create_device(process_t *process, uint64_t phys, uint64_t length) {
+	mmap_region_t *region = new_region(process, PAGE_ALIGN_UP(length), PAGE_USER | PAGE_WRITABLE | PAGE_SHARED | PAGE_NX);
+	return region != 0 ? map_frames(process, region, 0, phys) : 0;
+}
+
+uint64_t mmap_create_anonymous(process_t *process, uint64_t length) {
+	mmap_region_t *region = new_region(process, PAGE_ALIGN_UP(length), PAGE_USER | PAGE_WRITABLE | PAGE_NX);
+	if (region == 0)
+		return 0;
+
+	region->anonymous = 1;
+	process->mmap_count++;
+	return region->start;
+}
+
+int mmap_remove(process_t *process, uint64_t address) {
+	for (int i = 0; i < process->mmap_count; i++) {
+		mmap_region_t *region = &process->mmaps[i];
+		if (region->start != address)
+			continue;
+
+		for (uint64_t page = region->start; page < region->end; page += PAGE_SIZE)
+			pmm_free_frame(paging_unmap(process->space, page));
+
+		*region = process->mmaps[--process->mmap_count];
+		return 0;
+	}
+	return -1;
+}
+
+const mmap_region_t *mmap_find(const process_t *process, uint64_t address) {
+	for (int i = 0; i < process->mmap_count; i++)
+		if (address >= process->mmaps[i].start && address < process->mmaps[i].end)
+			return &process->mmaps[i];
+	return 0;
+}
+
+// La ultima pagina del archivo se copia: lo que sigue en el bloque no es del archivo
+static int map_file_end(address_space_t *space, uint64_t page, uint64_t frame, uint64_t length, uint64_t flags) {
+	uint64_t copy = pmm_alloc_frame();
+	if (copy == 0)
+		return -1;
+
+	memcpy(P2V(copy), P2V(frame), length);
+	memset((uint8_t *)P2V(copy) + length, 0, PAGE_SIZE - length);
+
+	if (flags & PAGE_COW)
+		flags = (flags & ~PAGE_COW) | PAGE_WRITABLE;
+	if (paging_map(space, page, copy, flags) != 0) {
+		pmm_free_frame(copy);
+		return -1;
+	}
+	return 0;
+}
+
+// La referencia del frame pasa a ser la del mapeo
+static int map_page(address_space_t *space, const mmap_region_t *region, uint64_t page, uint64_t frame) {
+	uint64_t offset = region->offset + (page - region->start);
+	int result;
+
+	if (offset + PAGE_SIZE <= region->file->size) {
+		result = paging_map(space, page, frame, region->flags);
+		if (result != 0)
+			pmm_free_frame(frame);
+	} else {
+		result = map_file_end(space, page, frame, region->file->size - offset, region->flags);
+		pmm_free_frame(frame);
+	}
+	return result;
+}
+
+static int map_zero_page(address_space_t *space, const mmap_region_t *region, uint64_t page) {
+	uint64_t frame = pmm_alloc_frame();
+	if (frame == 0)
+		return 0;
+
+	memset(P2V(frame), 0, PAGE_SIZE);
+	if (paging_map(space, page, frame, region->flags) != 0) {
+		pmm_free_frame(frame);
+		return 0;
+	}
+	return 1;
+}
+
+/*
+ * Un fallo que lee del disco trae tambien el readahead del cache, asi que se
+ * aprovecha para mapear las paginas siguientes que ya esten en memoria y
+ * ahorrar esos fallos.
+ */
+int mmap_handle_fault(process_t *process, const mmap_region_t *region, uint64_t address) {
+	if (region->anonymous)
+		return map_zero_page(process->space, region, PAGE_ALIGN_DOWN(address));
+
+	// La memoria compartida y la de dispositivos estan siempre mapeadas enteras
+	if (region->file == 0)
+		return 0;
+
+	uint64_t page = PAGE_ALIGN_DOWN(address);
+	uint64_t frame = bmfs_page(region->file, region->offset + (page - region->start));
+
+	if (frame == 0 || map_page(process->space, region, page, frame) != 0)
+		return 0;
+
+	for (int i = 1; i < MMAP_FAULT_AROUND_PAGES; i++) {
+		page += PAGE_SIZE;
+		if (page >= region->end || paging_flags(process->space, page) & PAGE_PRESENT)
+			break;
+
+		frame = bmfs_cached_page(region->file, region->offset + (page - region->start));
+		if (frame == 0 || map_page(process->space, region, page, frame) != 0)
+			break;
+	}
+	return 1;
+}
@@ -0,0 +1,375 @@
+#include <stdint.h>
+#include <paging.h>
+#include <pmm.h>
+#include <lib.h>
+
+#define ENTRIES_PER_TABLE 512
+#define MAX_ADDRESS_SPACES 64
+
+#define PML4_INDEX(va) (((va) >> 39) & 0x1FF)
+#define PDPT_INDEX(va) (((va) >> 30) & 0x1FF)
+#define PD_INDEX(va)   (((va) >> 21) & 0x1FF)
+#define PT_INDEX(va)   (((va) >> 12) & 0x1FF)
+
+#define GIB 0x40000000ULL
+#define LARGE_PAGE_SIZE 0x200000ULL
+#define MAX_DIRECT_MAP_GIB 512
+#define IDENTITY_GIB_END 4                                  // identity de [1 GiB, 4 GiB)
+#define KERNEL_PD_ENTRIES (USER_SPACE_START / LARGE_PAGE_SIZE)
+#define DIRECT_MAP_PML4_INDEX PML4_INDEX(DIRECT_MAP_BASE)
+
+#define TABLE_FLAGS (PAGE_PRESENT | PAGE_WRITABLE)
+#define USER_TABLE_FLAGS (PAGE_PRESENT | PAGE_WRITABLE | PAGE_USER)
+#define KERNEL_LARGE_PAGE_FLAGS (PAGE_PRESENT | PAGE_WRITABLE | PAGE_HUGE | PAGE_GLOBAL)
+
+#define CR0_WP (1ULL << 16)
+#define CR3_NOFLUSH (1ULL << 63)
+#define CR4_PCIDE (1ULL << 17)
+#define CPUID_ECX_PCID (1 << 17)        // leaf 0x1
+#define CPUID_EDX_PAGE1GB (1 << 26)     // leaf 0x80000001
+#define CPUID_EDX_NX (1 << 20)          // leaf 0x80000001
+#define MSR_EFER 0xC0000080
+#define EFER_NXE (1ULL << 11)
+
+#define TABLE(phys) ((uint64_t *)P2V((phys) & PAGE_ADDRESS_MASK))
+
+static address_space_t kernel_space;
+static address_space_t spaces[MAX_ADDRESS_SPACES];
+static address_space_t *current_space;
+
+static uint64_t kernel_pdpt_low;
+static uint64_t kernel_pd_low;
+static uint8_t pcid_supported;
+static uint8_t nx_supported;
+
+static uint64_t alloc_table(void);
+static uint64_t build_direct_map(uint8_t use_1g_pages);
+static uint64_t *walk(address_space_t *space, uint64_t virt, int create);
+static void invalidate(address_space_t *space, uint64_t virt);
+
+static int is_user_address(uint64_t virt) {
+	return virt >= USER_SPACE_START && virt < USER_SPACE_END;
+}
+
+//=============================================================================
+// ADDRESS SPACE MANAGEMENT
+//=============================================================================
+
+void paging_init(void) {
+	uint32_t regs[4];
+
+	_cpuid(0x1, 0, regs);
+	pcid_supported = (regs[2] & CPUID_ECX_PCID) != 0;
+	_cpuid(0x80000001, 0, regs);
+	nx_supported = (regs[3] & CPUID_EDX_NX) != 0;
+	if (nx_supported)
+		writeMSR(MSR_EFER, readMSR(MSR_EFER) | EFER_NXE);
+	uint64_t direct_pdpt = build_direct_map((regs[3] & CPUID_EDX_PAGE1GB) != 0);
+
+	// Primer GiB: el kernel identity con paginas de 2 MiB, el resto para userland
+	kernel_pd_low = alloc_table();
+	for (uint64_t i = 0; i < KERNEL_PD_ENTRIES; i++)
+		TABLE(kernel_pd_low)[i] = i * LARGE_PAGE_SIZE | KERNEL_LARGE_PAGE_FLAGS;
+
+	// GiB 1 a 3: mismo mapeo que el direct map (identity), sin tablas propias
+	kernel_pdpt_low = alloc_table();
+	TABLE(kernel_pdpt_low)[0] = kernel_pd_low | USER_TABLE_FLAGS;
+	for (int gib = 1; gib < IDENTITY_GIB_END; gib++)
+		TABLE(kernel_pdpt_low)[gib] = TABLE(direct_pdpt)[gib];
+
+	kernel_space.pml4 = alloc_table();
+	TABLE(kernel_space.pml4)[0] = kernel_pdpt_low | USER_TABLE_FLAGS;
+	TABLE(kernel_space.pml4)[DIRECT_MAP_PML4_INDEX] = direct_pdpt | TABLE_FLAGS;
+	kernel_space.pcid = 0;
+	kernel_space.needs_flush = 1;
+	kernel_space.in_use = 1;
+
+	// CR4.PCIDE solo se puede prender con CR3[11:0] == 0, por eso va despues
+	paging_switch(&kernel_space);
+	if (pcid_supported)
+		writeCR4(readCR4() | CR4_PCIDE);
+
+	// Userland corre en CPL0: sin WP las escrituras ignorarian el bit R/W y
+	// las paginas copy-on-write se modificarian in place
+	writeCR0(readCR0() | CR0_WP);
+}
+
+address_space_t *paging_create_address_space(void) {
+	uint64_t pml4, pdpt, pd;
+	int slot = 0;
+
+	while (slot < MAX_ADDRESS_SPACES && spaces[slot].in_use)
+		slot++;
+	if (slot == MAX_ADDRESS_SPACES)
+		return 0;
+	address_space_t *space = &spaces[slot];
+
+	pml4 = alloc_table();
+	pdpt = alloc_table();
+	pd = alloc_table();
+	if (pml4 == 0 || pdpt == 0 || pd == 0) {
+		pmm_free_frame(pml4);
+		pmm_free_frame(pdpt);
+		pmm_free_frame(pd);
+		return 0;
+	}
+
+	for (uint64_t i = 0; i < KERNEL_PD_ENTRIES; i++)
+		TABLE(pd)[i] = TABLE(kernel_pd_low)[i];
+
+	TABLE(pdpt)[0] = pd | USER_TABLE_FLAGS;
+	for (int gib = 1; gib < IDENTITY_GIB_END; gib++)
+		TABLE(pdpt)[gib] = TABLE(kernel_pdpt_low)[gib];
+
+	TABLE(pml4)[0] = pdpt | USER_TABLE_FLAGS;
+	TABLE(pml4)[DIRECT_MAP_PML4_INDEX] = TABLE(kernel_space.pml4)[DIRECT_MAP_PML4_INDEX];
+
+	// Un PCID fijo por slot (el 0 es del kernel): nunca se agotan y al reusar
+	// el slot se invalida la TLB
+	space->pml4 = pml4;
+	space->pcid = pcid_supported ? slot + 1 : 0;
+	space->needs_flush = 1;
+	space->in_use = 1;
+	return space;
+}
+
+void paging_destroy_address_space(address_space_t *space) {
+	if (space == current_space)
+		paging_switch(&kernel_space);
+
+	uint64_t pdpt = TABLE(space->pml4)[0];
+	uint64_t pd = TABLE(pdpt)[0];
+
+	// Toda la region de usuario vive en el primer PD
+	for (int i = KERNEL_PD_ENTRIES; i < ENTRIES_PER_TABLE; i++) {
+		uint64_t pt = TABLE(pd)[i];
+		if (!(pt & PAGE_PRESENT))
+			continue;
+
+		for (int j = 0; j < ENTRIES_PER_TABLE; j++)
+			if (TABLE(pt)[j] & PAGE_PRESENT)
+				pmm_free_frame(TABLE(pt)[j] & PAGE_ADDRESS_MASK);
+		pmm_free_frame(pt & PAGE_ADDRESS_MASK);
+	}
+
+	pmm_free_frame(pd & PAGE_ADDRESS_MASK);
+	pmm_free_frame(pdpt & PAGE_ADDRESS_MASK);
+	pmm_free_frame(space->pml4);
+	space->in_use = 0;
+}
+
+void paging_switch(address_space_t *space) {
+	uint64_t cr3 = space->pml4;
+
+	if (pcid_supported) {
+		cr3 |= space->pcid;
+		if (!space->needs_flush)
+			cr3 |= CR3_NOFLUSH;
+	}
+
+	space->needs_flush = 0;
+	current_space = space;
+	writeCR3(cr3);
+}
+
+address_space_t *paging_kernel_space(void) {
+	return &kernel_space;
+}
+
+address_space_t *paging_current(void) {
+	return current_space;
+}
+
+//=============================================================================
+// USER MAPPINGS (4 KiB)
+//=============================================================================
+
+int paging_map(address_space_t *space, uint64_t virt, uint64_t phys, uint64_t flags) {
+	if (!is_user_address(virt))
+		return -1;
+
+	uint64_t *entry = walk(space, virt, 1);
+	if (entry == 0)
+		return -1;
+
+	// Sin EFER.NXE el bit 63 es reservado y provocaria un page fault
+	if (!nx_supported)
+		flags &= ~PAGE_NX;
+
+	uint64_t old = *entry;
+	*entry = (phys & PAGE_ADDRESS_MASK) | flags | PAGE_PRESENT;
+	if (old & PAGE_PRESENT)
+		invalidate(space, virt);
+	return 0;
+}
+
+uint64_t paging_unmap(address_space_t *space, uint64_t virt) {
+	if (!is_user_address(virt))
+		return 0;
+
+	uint64_t *entry = walk(space, virt, 0);
+	if (entry == 0 || !(*entry & PAGE_PRESENT))
+		return 0;
+
+	uint64_t phys = *entry & PAGE_ADDRESS_MASK;
+	*entry = 0;
+	invalidate(space, virt);
+	return phys;
+}
+
+uint64_t paging_translate(address_space_t *space, uint64_t virt) {
+	uint64_t *entry = walk(space, virt, 0);
+	if (entry == 0 || !(*entry & PAGE_PRESENT))
+		return 0;
+	return (*entry & PAGE_ADDRESS_MASK) | (virt & (PAGE_SIZE - 1));
+}
+
+uint64_t paging_flags(address_space_t *space, uint64_t virt) {
+	uint64_t *entry = walk(space, virt, 0);
+	if (entry == 0 || !(*entry & PAGE_PRESENT))
+		return 0;
+	return *entry & ~PAGE_ADDRESS_MASK;
+}
+
+//=============================================================================
+// COPY-ON-WRITE
+//=============================================================================
+
+address_space_t *paging_fork(address_space_t *parent) {
+	address_space_t *child = paging_create_address_space();
+	if (child == 0)
+		return 0;
+
+	uint64_t parent_pd = TABLE(TABLE(parent->pml4)[0])[0];
+
+	for (uint64_t i = KERNEL_PD_ENTRIES; i < ENTRIES_PER_TABLE; i++) {
+		uint64_t pt = TABLE(parent_pd)[i];
+		if (!(pt & PAGE_PRESENT))
+			continue;
+
+		for (uint64_t j = 0; j < ENTRIES_PER_TABLE; j++) {
+			uint64_t *entry = &TABLE(pt)[j];
+			if (!(*entry & PAGE_PRESENT))
+				continue;
+
+			if ((*entry & (PAGE_WRITABLE | PAGE_COW)) && !(*entry & PAGE_SHARED))
+				*entry = (*entry & ~PAGE_WRITABLE) | PAGE_COW;
+
+			uint64_t virt = i * LARGE_PAGE_SIZE + j * PAGE_SIZE;
+			if (paging_map(child, virt, *entry & PAGE_ADDRESS_MASK, *entry & ~PAGE_ADDRESS_MASK) != 0) {
+				paging_destroy_address_space(child);
+				return 0;
+			}
+			pmm_ref_frame(*entry & PAGE_ADDRESS_MASK);
+		}
+	}
+
+	// Se quito el permiso de escritura de muchas paginas del padre a la vez
+	parent->needs_flush = 1;
+	if (parent == current_space)
+		paging_switch(parent);
+
+	return child;
+}
+
+int paging_copy_on_write(address_space_t *space, uint64_t virt) {
+	uint64_t *entry = walk(space, virt, 0);
+	if (entry == 0 || (*entry & (PAGE_PRESENT | PAGE_COW)) != (PAGE_PRESENT | PAGE_COW))
+		return -1;
+
+	uint64_t frame = *entry & PAGE_ADDRESS_MASK;
+	uint64_t flags = (*entry & ~(PAGE_ADDRESS_MASK | PAGE_COW)) | PAGE_WRITABLE;
+
+	// Frames fuera del pool (refs == 0) nunca son propios: siempre se copian
+	if (pmm_frame_refs(frame) == 1) {
+		*entry = frame | flags;
+	} else {
+		uint64_t copy = pmm_alloc_frame();
+		if (copy == 0)
+			return -1;
+		memcpy(P2V(copy), P2V(frame), PAGE_SIZE);
+		*entry = copy | flags;
+		pmm_free_frame(frame);
+	}
+
+	invalidate(space, virt & ~(PAGE_SIZE - 1));
+	return 0;
+}
+
+//=============================================================================
+// HELPERS
+//=============================================================================
+
+static uint64_t alloc_table(void) {
+	uint64_t table = pmm_alloc_frame();
+	if (table != 0)
+		memset(TABLE(table), 0, PAGE_SIZE);
+	return table;
+}
+
+/**
+ * Maps all physical memory (and at least the 4 GiB that hold the framebuffer
+ * and the APICs) at DIRECT_MAP_BASE, with 1 GiB pages when the CPU has them.
+ */
+static uint64_t build_direct_map(uint8_t use_1g_pages) {
+	uint64_t pdpt = alloc_table();
+	uint64_t gibs = (pmm_memory_end() + GIB - 1) / GIB;
+
+	if (gibs < IDENTITY_GIB_END)
+		gibs = IDENTITY_GIB_END;
+	if (gibs > MAX_DIRECT_MAP_GIB)
+		gibs = MAX_DIRECT_MAP_GIB;
+
+	for (uint64_t gib = 0; gib < gibs; gib++) {
+		if (use_1g_pages) {
+			TABLE(pdpt)[gib] = gib * GIB | KERNEL_LARGE_PAGE_FLAGS;
+			continue;
+		}
+
+		uint64_t pd = alloc_table();
+		for (uint64_t i = 0; i < ENTRIES_PER_TABLE; i++)
+			TABLE(pd)[i] = (gib * GIB + i * LARGE_PAGE_SIZE) | KERNEL_LARGE_PAGE_FLAGS;
+		TABLE(pdpt)[gib] = pd | TABLE_FLAGS;
+	}
+
+	return pdpt;
+}
+
+/**
+ * Walks the tables down to the PT entry of a virtual address, creating the
+ * intermediate tables if requested. Fails on large-page mappings.
+ */
+static uint64_t *walk(address_space_t *space, uint64_t virt, int create) {
+	uint64_t table = space->pml4;
+	uint64_t indexes[] = { PML4_INDEX(virt), PDPT_INDEX(virt), PD_INDEX(virt) };
+
+	for (int level = 0; level < 3; level++) {
+		uint64_t *entry = &TABLE(table)[indexes[level]];
+
+		if (!(*entry & PAGE_PRESENT)) {
+			if (!create)
+				return 0;
+			uint64_t next = alloc_table();
+			if (next == 0)
+				return 0;
+			*entry = next | USER_TABLE_FLAGS;
+		} else if (*entry & PAGE_HUGE) {
+			return 0;
+		}
+
+		table = *entry;
+	}
+
+	return &TABLE(table)[PT_INDEX(virt)];
+}
+
+/**
+ * Spaces that are not loaded may still have entries cached under their PCID,
+ * so they get a full flush the next time they are switched to.
+ */
+static void invalidate(address_space_t *space, uint64_t virt) {
+	if (space == current_space)
+		invalidatePage(virt);
+	else
+		space->needs_flush = 1;
+}
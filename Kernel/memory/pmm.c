@@ -0,0 +1,81 @@
+#include <stdint.h>
+#include <pmm.h>
+#include <lib.h>
+
+// Cantidad de memoria en MiB que Pure64 deja en el InfoMap
+#define PURE64_MEM_AMOUNT ((uint32_t *)0x5020)
+#define MIB 0x100000ULL
+
+/*
+ * Los frames nunca usados se reparten con un puntero que avanza (no hace falta
+ * recorrer toda la memoria al bootear) y los liberados se encadenan en una free
+ * list guardando el siguiente en los primeros 8 bytes de cada frame libre.
+ * Al principio del pool vive un contador de referencias por frame, para poder
+ * compartir frames entre espacios de direcciones (copy-on-write).
+ */
+static uint64_t memory_end;
+static uint64_t next_unused;
+static uint64_t free_list;
+static uint64_t free_count;
+static uint16_t *refcounts;
+
+static int in_pool(uint64_t frame) {
+	return frame >= PMM_POOL_START && frame < next_unused;
+}
+
+void pmm_init(void) {
+	memory_end = (uint64_t)*PURE64_MEM_AMOUNT * MIB;
+	free_list = 0;
+
+	uint64_t frames = memory_end > PMM_POOL_START ? (memory_end - PMM_POOL_START) / PAGE_SIZE : 0;
+	uint64_t refcounts_size = (frames * sizeof(uint16_t) + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+
+	refcounts = (uint16_t *)P2V(PMM_POOL_START);
+	memset(refcounts, 0, refcounts_size);
+	next_unused = PMM_POOL_START + refcounts_size;
+	free_count = memory_end > next_unused ? (memory_end - next_unused) / PAGE_SIZE : 0;
+}
+
+uint64_t pmm_alloc_frame(void) {
+	uint64_t frame;
+
+	if (free_list != 0) {
+		frame = free_list;
+		free_list = *(uint64_t *)P2V(frame);
+	} else if (next_unused + PAGE_SIZE <= memory_end) {
+		frame = next_unused;
+		next_unused += PAGE_SIZE;
+	} else {
+		return 0;
+	}
+
+	free_count--;
+	refcounts[(frame - PMM_POOL_START) / PAGE_SIZE] = 1;
+	return frame;
+}
+
+void pmm_ref_frame(uint64_t frame) {
+	if (in_pool(frame))
+		refcounts[(frame - PMM_POOL_START) / PAGE_SIZE]++;
+}
+
+uint64_t pmm_frame_refs(uint64_t frame) {
+	return in_pool(frame) ? refcounts[(frame - PMM_POOL_START) / PAGE_SIZE] : 0;
+}
+
+void pmm_free_frame(uint64_t frame) {
+	if (!in_pool(frame) || --refcounts[(frame - PMM_POOL_START) / PAGE_SIZE] != 0)
+		return;
+
+	*(uint64_t *)P2V(frame) = free_list;
+	free_list = frame;
+	free_count++;
+}
+
+uint64_t pmm_memory_end(void) {
+	return memory_end;
+}
+
+uint64_t pmm_free_frame_count(void) {
+	return free_count;
+}
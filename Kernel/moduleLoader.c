@@ -2,42 +2,159 @@
 #include <lib.h>
 #include <moduleLoader.h>
 #include <naiveConsole.h>
+#include <lz4.h>
 
-static void loadModule(uint8_t ** module, void * targetModuleAddress);
-static uint32_t readUint32(uint8_t ** address);
+#define ALIGN_UP(x) (((uint64_t)(x) + MODULE_ALIGNMENT - 1) & ~(uint64_t)(MODULE_ALIGNMENT - 1))
 
-void loadModules(void * payloadStart, void ** targetModuleAddress)
+static void loadModule(const uint8_t * payload, const module_index_entry_t * entry);
+static void printModule(const module_index_entry_t * entry, const uint8_t * address, uint64_t cycles, int valid);
+static uint32_t crc32(const uint8_t * data, uint64_t length);
+
+static module_t modules[MAX_MODULES];
+static uint32_t moduleCount;
+static uint8_t * nextAreaAddress = (uint8_t*)MODULE_AREA_START;
+
+/*
+ * Formato: una tabla (nombre, offset, tamanio, checksum) al principio del
+ * payload, y los modulos empezando cada uno en su propia pagina.
+ */
+void loadModules(void * payloadStart)
+{
+	const module_index_header_t * header = (const module_index_header_t*)payloadStart;
+	const module_index_entry_t * entries = (const module_index_entry_t*)(header + 1);
+	uint32_t i;
+
+	if (header->magic != MODULE_INDEX_MAGIC)
+	{
+		ncPrint("  No module index");
+		ncNewline();
+		return;
+	}
+
+	for (i = 0; i < header->count && i < MAX_MODULES; i++)
+		loadModule((const uint8_t*)payloadStart, &entries[i]);
+
+	if (header->count > MAX_MODULES)
+	{
+		ncPrint("  Only ");
+		ncPrintDec(MAX_MODULES);
+		ncPrint(" of ");
+		ncPrintDec(header->count);
+		ncPrint(" modules loaded, dropped:");
+		for (; i < header->count; i++)
+		{
+			ncPrint(" ");
+			ncPrint(entries[i].name);
+		}
+		ncNewline();
+	}
+}
+
+uint32_t getModuleCount(void)
+{
+	return moduleCount;
+}
+
+const module_t * getModule(uint32_t index)
 {
-	int i;
-	uint8_t * currentModule = (uint8_t*)payloadStart;
-	uint32_t moduleCount = readUint32(&currentModule);
+	return index < moduleCount && modules[index].address != 0 ? &modules[index] : 0;
+}
+
+int findModule(const char * name)
+{
+	uint32_t i;
 
 	for (i = 0; i < moduleCount; i++)
-		loadModule(&currentModule, targetModuleAddress[i]);
+		if (modules[i].address != 0 && strncmp(modules[i].name, name, MODULE_NAME_LENGTH) == 0)
+			return i;
+	return -1;
 }
 
-static void loadModule(uint8_t ** module, void * targetModuleAddress)
+// Un modulo corrupto conserva su posicion (los indices no cambian) pero no se usa
+static void loadModule(const uint8_t * payload, const module_index_entry_t * entry)
 {
-	uint32_t moduleSize = readUint32(module);
+	module_t * module = &modules[moduleCount++];
+	uint8_t * address = (uint8_t*)(payload + entry->offset);
+	uint64_t cycles = 0;
+	int valid = 1;
+
+	// Los comprimidos no se pueden usar in place
+	if (entry->flags & MODULE_LZ4)
+	{
+		uint64_t start = readTSC();
+
+		valid = (uint64_t)(nextAreaAddress + entry->size) <= MODULE_AREA_END
+				&& lz4_decompress(address, entry->packed_size, nextAreaAddress, entry->size) == 0;
+		if (valid)
+		{
+			address = nextAreaAddress;
+			nextAreaAddress = (uint8_t*)ALIGN_UP(nextAreaAddress + entry->size);
+			// El relleno de la ultima pagina tiene que ser cero, como en el payload
+			memset(address + entry->size, 0, (uint64_t)nextAreaAddress - (uint64_t)address - entry->size);
+		}
+		cycles = readTSC() - start;
+	}
+
+	valid = valid && (uint64_t)address % MODULE_ALIGNMENT == 0 && crc32(address, entry->size) == entry->checksum;
+	if (valid)
+	{
+		memcpy(module->name, entry->name, MODULE_NAME_LENGTH);
+		module->name[MODULE_NAME_LENGTH - 1] = 0;
+		module->address = address;
+		module->size = entry->size;
+	}
 
-	ncPrint("  Will copy module at 0x");
-	ncPrintHex((uint64_t)*module);
-	ncPrint(" to 0x");
-	ncPrintHex((uint64_t)targetModuleAddress);
+	printModule(entry, address, cycles, valid);
+}
+
+// El detalle solo con VERBOSE_BOOT (escribir en pantalla tambien cuesta); los errores siempre
+static void printModule(const module_index_entry_t * entry, const uint8_t * address, uint64_t cycles, int valid)
+{
+#ifndef VERBOSE_BOOT
+	if (valid)
+		return;
+#endif
+	ncPrint("  Module ");
+	ncPrint(entry->name);
 	ncPrint(" (");
-	ncPrintDec(moduleSize);
+	ncPrintDec(entry->size);
 	ncPrint(" bytes)");
 
-	memcpy(targetModuleAddress, *module, moduleSize);
-	*module += moduleSize;
+	if (entry->flags & MODULE_LZ4)
+	{
+		ncPrint(" lz4 ");
+		ncPrintDec(entry->packed_size);
+		ncPrint(" bytes, ");
+		ncPrintDec(cycles);
+		ncPrint(" cycles");
+	}
 
-	ncPrint(" [Done]");
+	ncPrint(" at 0x");
+	ncPrintHex((uint64_t)address);
+	ncPrint(valid ? " [Done]" : " [Bad module]");
 	ncNewline();
 }
 
-static uint32_t readUint32(uint8_t ** address)
+// CRC-32 (IEEE), el mismo que calcula el ModulePacker
+static uint32_t crc32(const uint8_t * data, uint64_t length)
 {
-	uint32_t result = *(uint32_t*)(*address);
-	*address += sizeof(uint32_t);
-	return result;
+	static uint32_t table[256];
+	static int initialized = 0;
+	uint32_t crc = 0xFFFFFFFF;
+
+	if (!initialized)
+	{
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t value = i;
+			for (int j = 0; j < 8; j++)
+				value = value & 1 ? (value >> 1) ^ 0xEDB88320 : value >> 1;
+			table[i] = value;
+		}
+		initialized = 1;
+	}
+
+	while (length--)
+		crc = table[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+	return crc ^ 0xFFFFFFFF;
 }
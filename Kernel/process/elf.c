@@ -0,0 +1,151 @@
+#include <stdint.h>
+#include <elf.h>
+#include <paging.h>
+#include <pmm.h>
+#include <lib.h>
+
+#define PAGE_ALIGN_DOWN(x) ((x) & ~(PAGE_SIZE - 1))
+#define PAGE_ALIGN_UP(x) (((x) + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1))
+
+// Los program headers tienen que estar en la primera pagina
+static int is_valid_header(const elf64_header_t *header, uint64_t size) {
+	return size >= sizeof(elf64_header_t)
+		&& header->e_magic == ELF_MAGIC
+		&& header->e_class == ELFCLASS64
+		&& header->e_data == ELFDATA2LSB
+		&& header->e_type == ET_EXEC
+		&& header->e_machine == EM_X86_64
+		&& header->e_phentsize == sizeof(elf64_program_header_t)
+		&& header->e_phoff + header->e_phnum * sizeof(elf64_program_header_t) <= size
+		&& header->e_phoff + header->e_phnum * sizeof(elf64_program_header_t) <= PAGE_SIZE;
+}
+
+static uint64_t page_flags(uint32_t segment_flags) {
+	uint64_t flags = PAGE_USER;
+	if (segment_flags & PF_W)
+		flags |= PAGE_WRITABLE;
+	if (!(segment_flags & PF_X))
+		flags |= PAGE_NX;
+	return flags;
+}
+
+/*
+ * Las paginas de los bordes se copian: lo que rodea al segmento en la imagen
+ * (antes de p_vaddr o despues del final del archivo) tiene que verse en cero.
+ * Si el segmento anterior termina en la misma pagina, se conserva lo suyo.
+ */
+static int map_copy(address_space_t *space, uint64_t virt, uint64_t source, uint64_t from, uint64_t to, uint64_t flags) {
+	uint64_t frame = pmm_alloc_frame();
+	if (frame == 0)
+		return -1;
+
+	uint64_t previous = paging_translate(space, virt);
+	uint64_t previous_flags = paging_flags(space, virt);
+	if (previous != 0) {
+		memcpy(P2V(frame), P2V(previous), PAGE_SIZE);
+		if (!(previous_flags & PAGE_NX))
+			flags &= ~PAGE_NX;
+		if (previous_flags & (PAGE_WRITABLE | PAGE_COW))
+			flags |= PAGE_WRITABLE;
+	} else {
+		memset(P2V(frame), 0, PAGE_SIZE);
+	}
+	memcpy((uint8_t *)P2V(frame) + from, (uint8_t *)P2V(source) + from, to - from);
+
+	if (paging_map(space, virt, frame, flags) != 0) {
+		pmm_free_frame(frame);
+		return -1;
+	}
+	if (previous != 0)
+		pmm_free_frame(previous);
+	return 0;
+}
+
+static int map_segment(address_space_t *space, elf_page_reader_t read_page, const void *source, const elf64_program_header_t *segment) {
+	uint64_t flags = page_flags(segment->p_flags);
+	uint64_t start = PAGE_ALIGN_DOWN(segment->p_vaddr);
+	uint64_t file_end = segment->p_vaddr + segment->p_filesz;
+	uint64_t offset = PAGE_ALIGN_DOWN(segment->p_offset);
+
+	// Los frames de la imagen se comparten: se escriben solo via copy-on-write
+	uint64_t shared_flags = flags & PAGE_WRITABLE ? (flags & ~PAGE_WRITABLE) | PAGE_COW : flags;
+
+	// Solo .bss: sus paginas se materializan en cero al tocarlas
+	if (segment->p_filesz == 0)
+		return 0;
+
+	for (uint64_t page = start; page < file_end; page += PAGE_SIZE, offset += PAGE_SIZE) {
+		uint64_t frame = read_page(source, offset);
+		if (frame == 0)
+			return -1;
+
+		int result;
+		if (page >= segment->p_vaddr && page + PAGE_SIZE <= file_end) {
+			// La referencia del lector pasa a ser la del mapeo
+			result = paging_map(space, page, frame, shared_flags);
+			if (result != 0)
+				pmm_free_frame(frame);
+		} else {
+			uint64_t from = page < segment->p_vaddr ? segment->p_vaddr - page : 0;
+			uint64_t to = page + PAGE_SIZE < file_end ? PAGE_SIZE : file_end - page;
+			result = map_copy(space, page, frame, from, to, flags);
+			pmm_free_frame(frame);
+		}
+
+		if (result != 0)
+			return -1;
+	}
+	return 0;
+}
+
+static int load_segments(address_space_t *space, elf_page_reader_t read_page, const void *source, uint64_t size,
+		const elf64_header_t *header, uint64_t *entry, bss_region_t *bss) {
+	const elf64_program_header_t *segments = (const elf64_program_header_t *)((const uint8_t *)header + header->e_phoff);
+	int bss_count = 0;
+
+	if (!is_valid_header(header, size))
+		return -1;
+
+	for (int i = 0; i < header->e_phnum; i++) {
+		const elf64_program_header_t *segment = &segments[i];
+		if (segment->p_type != PT_LOAD || segment->p_memsz == 0)
+			continue;
+
+		if (segment->p_filesz > segment->p_memsz
+				|| segment->p_offset + segment->p_filesz > size
+				|| segment->p_vaddr % PAGE_SIZE != segment->p_offset % PAGE_SIZE
+				|| segment->p_vaddr < USER_IMAGE_START
+				|| segment->p_vaddr + segment->p_memsz > USER_IMAGE_END
+				|| map_segment(space, read_page, source, segment) != 0)
+			return -1;
+
+		uint64_t file_end = segment->p_vaddr + segment->p_filesz;
+		uint64_t bss_start = segment->p_filesz == 0 ? PAGE_ALIGN_DOWN(segment->p_vaddr) : PAGE_ALIGN_UP(file_end);
+		uint64_t bss_end = PAGE_ALIGN_UP(segment->p_vaddr + segment->p_memsz);
+
+		if (bss_start < bss_end) {
+			if (bss_count == MAX_BSS_REGIONS)
+				return -1;
+			bss[bss_count].start = bss_start;
+			bss[bss_count].end = bss_end;
+			bss[bss_count].flags = page_flags(segment->p_flags);
+			bss_count++;
+		}
+	}
+
+	if (header->e_entry < USER_IMAGE_START || header->e_entry >= USER_IMAGE_END)
+		return -1;
+
+	*entry = header->e_entry;
+	return bss_count;
+}
+
+int elf_load(address_space_t *space, elf_page_reader_t read_page, const void *source, uint64_t size, uint64_t *entry, bss_region_t *bss) {
+	uint64_t header_frame = read_page(source, 0);
+	if (header_frame == 0)
+		return -1;
+
+	int bss_count = load_segments(space, read_page, source, size, P2V(header_frame), entry, bss);
+	pmm_free_frame(header_frame);
+	return bss_count;
+}
@@ -0,0 +1,575 @@
+#include <stdint.h>
+#include <process.h>
+#include <scheduler.h>
+#include <paging.h>
+#include <pmm.h>
+#include <lib.h>
+#include <interrupts.h>
+#include <moduleLoader.h>
+#include <elf.h>
+#include <bmfs.h>
+#include <diskQueue.h>
+#include <mmap.h>
+#include <file.h>
+
+#define KERNEL_CODE_SELECTOR 0x08
+#define INITIAL_RFLAGS 0x202            // IF encendido
+
+#define PF_PRESENT (1 << 0)
+#define PF_WRITE   (1 << 1)
+
+#define PAGE_ALIGN_DOWN(x) ((x) & ~(PAGE_SIZE - 1))
+#define PAGE_ALIGN_UP(x) (((x) + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1))
+
+#define FAULT_STACK_SIZE 0x2000
+#define KERNEL_STACK_SIZE 0x4000
+
+// Un programa cargado y listo para arrancar, todavia sin proceso
+typedef struct {
+	address_space_t *space;
+	uint64_t entry;
+	bss_region_t bss[MAX_BSS_REGIONS];
+	int bss_count;
+} image_t;
+
+static process_t processes[MAX_PROCESSES];
+static uint64_t next_pid = 1;
+static uint64_t init_pid = 0;
+
+// Cada proceso atiende sus page faults en un stack propio: pueden bloquearse
+static uint8_t fault_stacks[MAX_PROCESSES][FAULT_STACK_SIZE] __attribute__((aligned(16)));
+
+// Y sus IRQs y syscalls en otro: ahi queda tambien su contexto guardado
+static uint8_t kernel_stacks[MAX_PROCESSES][KERNEL_STACK_SIZE] __attribute__((aligned(16)));
+
+static process_t *alloc_process(void) {
+	for (int i = 0; i < MAX_PROCESSES; i++) {
+		if (processes[i].state == PROCESS_UNUSED) {
+			memset(&processes[i], 0, sizeof(process_t));
+			processes[i].pid = next_pid++;
+			processes[i].leader = &processes[i];
+			return &processes[i];
+		}
+	}
+	return 0;
+}
+
+static process_t *find_process(uint64_t pid) {
+	for (int i = 0; i < MAX_PROCESSES; i++)
+		if (processes[i].state != PROCESS_UNUSED && processes[i].pid == pid)
+			return &processes[i];
+	return 0;
+}
+
+static int in_range(uint64_t address, uint64_t start, uint64_t end) {
+	return address >= start && address < end;
+}
+
+static int map_zeroed(address_space_t *space, uint64_t page, uint64_t flags) {
+	uint64_t frame = pmm_alloc_frame();
+	if (frame == 0)
+		return 0;
+
+	memset(P2V(frame), 0, PAGE_SIZE);
+	if (paging_map(space, page, frame, flags) != 0) {
+		pmm_free_frame(frame);
+		return 0;
+	}
+	return 1;
+}
+
+//=============================================================================
+// PROCESS LIFECYCLE
+//=============================================================================
+
+process_t *process_table(void) {
+	return processes;
+}
+
+process_t *process_current(void) {
+	return scheduler_current()->leader;
+}
+
+uint64_t process_fault_stack(const process_t *process) {
+	return (uint64_t)(fault_stacks[process - processes] + FAULT_STACK_SIZE);
+}
+
+uint64_t process_kernel_stack(const process_t *process) {
+	return (uint64_t)(kernel_stacks[process - processes] + KERNEL_STACK_SIZE);
+}
+
+void process_build_frame(interrupt_frame_t *frame, uint64_t entry, uint64_t stack) {
+	memset(frame, 0, sizeof(interrupt_frame_t));
+	frame->rip = entry;
+	frame->cs = KERNEL_CODE_SELECTOR;
+	frame->rflags = INITIAL_RFLAGS;
+	frame->rsp = stack - sizeof(uint64_t);      // como si un call hubiera pusheado el retorno
+	frame->ss = 0;
+}
+
+/*
+ * El contexto inicial se arma en el tope del stack de kernel, donde lo dejaria
+ * una interrupcion; el stack del programa se materializa entero al tocarlo.
+ */
+static uint64_t initial_context(process_t *process, uint64_t entry, uint64_t stack) {
+	interrupt_frame_t *frame = (interrupt_frame_t *)process_kernel_stack(process) - 1;
+	process_build_frame(frame, entry, stack);
+	return (uint64_t)frame;
+}
+
+static int build_image(elf_page_reader_t read_page, const void *source, uint64_t size, image_t *image) {
+	image->space = paging_create_address_space();
+	if (image->space == 0)
+		return -1;
+
+	image->bss_count = elf_load(image->space, read_page, source, size, &image->entry, image->bss);
+	if (image->bss_count < 0) {
+		paging_destroy_address_space(image->space);
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Los modulos quedan en memoria (alineados a pagina) durante todo el uptime,
+ * asi que sus segmentos se mapean in place desde el payload. Sus frames estan
+ * fuera del pool: las referencias no cuentan.
+ */
+static uint64_t module_page(const void *module, uint64_t offset) {
+	return V2P(((const module_t *)module)->address) + offset;
+}
+
+static int build_module_image(uint32_t index, image_t *image) {
+	const module_t *module = getModule(index);
+	return module != 0 ? build_image(module_page, module, module->size, image) : -1;
+}
+
+// Los archivos se mapean desde los frames del block cache
+static uint64_t file_page(const void *file, uint64_t offset) {
+	return bmfs_page((const bmfs_entry_t *)file, offset);
+}
+
+static int build_file_image(const char *name, image_t *image) {
+	const bmfs_entry_t *file = bmfs_find(name);
+	return file != 0 ? build_image(file_page, file, file->size, image) : -1;
+}
+
+// Primero los modulos del payload (ya en memoria), despues los archivos del disco
+static int build_named_image(const char *name, image_t *image) {
+	int module = findModule(name);
+	return module >= 0 ? build_module_image(module, image) : build_file_image(name, image);
+}
+
+static void set_image(process_t *process, const image_t *image) {
+	memcpy(process->bss, image->bss, sizeof(process->bss));
+	process->bss_count = image->bss_count;
+	process->mmap_count = 0;
+	process->heap_start = process->heap_end = USER_HEAP_START;
+}
+
+static process_t *create_process(const image_t *image, uint64_t parent_pid) {
+	process_t *process = alloc_process();
+	if (process == 0) {
+		paging_destroy_address_space(image->space);
+		return 0;
+	}
+
+	set_image(process, image);
+	process->rsp = initial_context(process, image->entry, USER_STACK_TOP);
+	process->space = image->space;
+	process->parent_pid = parent_pid;
+	process->state = PROCESS_READY;
+	return process;
+}
+
+static const bss_region_t *find_bss(const process_t *process, uint64_t address) {
+	for (int i = 0; i < process->bss_count; i++)
+		if (in_range(address, process->bss[i].start, process->bss[i].end))
+			return &process->bss[i];
+	return 0;
+}
+
+process_t *process_create_init(void) {
+	image_t image;
+
+	if (build_module_image(INIT_MODULE, &image) != 0)
+		return 0;
+
+	process_t *process = create_process(&image, 0);
+	if (process != 0)
+		init_pid = process->pid;
+	return process;
+}
+
+void process_complete_exec(process_t *process) {
+	paging_destroy_address_space(process->space);
+	process->space = process->exec_space;
+	process->exec_space = 0;
+	process->rsp = initial_context(process, process->exec_entry, USER_STACK_TOP);
+}
+
+static int is_thread(const process_t *process) {
+	return process->leader != process;
+}
+
+static uint64_t thread_stack_top(int slot) {
+	return USER_THREAD_STACKS_START + (uint64_t)(slot + 1) * THREAD_STACK_SIZE;
+}
+
+// Los procesos que esperan un hijo pueden ser cualquiera de sus threads
+static void wake_group(const process_t *leader) {
+	for (int i = 0; i < MAX_PROCESSES; i++)
+		if (processes[i].state == PROCESS_BLOCKED && processes[i].leader == leader)
+			scheduler_unblock(&processes[i]);
+}
+
+static void release_resources(process_t *process) {
+	// Las transferencias en curso tienen sus frames referenciados
+	disk_release_owner(process->pid);
+	file_close_all(process);
+
+	if (process->space != 0) {
+		paging_destroy_address_space(process->space);
+		process->space = 0;
+	}
+
+	// Nadie va a hacer join de los threads que quedaron
+	for (int i = 0; i < MAX_PROCESSES; i++)
+		if (is_thread(&processes[i]) && processes[i].leader == process && processes[i].state == PROCESS_ZOMBIE)
+			processes[i].state = PROCESS_UNUSED;
+
+	process_t *parent = find_process(process->parent_pid);
+	if (parent != 0)
+		wake_group(parent);
+	else
+		process->state = PROCESS_UNUSED;
+}
+
+// El stack de un thread se devuelve al terminar; el lider puede estar esperandolo
+static void release_thread(process_t *thread) {
+	process_t *leader = thread->leader;
+	uint64_t top = thread_stack_top(thread->stack_slot);
+
+	for (uint64_t page = top - THREAD_STACK_SIZE; page < top; page += PAGE_SIZE)
+		pmm_free_frame(paging_unmap(thread->space, page));
+	thread->space = 0;
+
+	leader->thread_slots &= ~(1U << thread->stack_slot);
+	leader->thread_count--;
+	if (leader->thread_count == 0 && leader->state == PROCESS_ZOMBIE)
+		release_resources(leader);
+}
+
+void process_release(process_t *process) {
+	if (is_thread(process))
+		release_thread(process);
+	else if (process->thread_count == 0)
+		release_resources(process);
+}
+
+static void terminate_thread(process_t *thread, int64_t exit_code) {
+	thread->exit_code = exit_code;
+	thread->state = PROCESS_ZOMBIE;
+	for (int i = 0; i < MAX_PROCESSES; i++)
+		if (processes[i].joining == thread->pid)
+			scheduler_unblock(&processes[i]);
+}
+
+void process_terminate(process_t *process, int64_t exit_code) {
+	if (is_thread(process)) {
+		terminate_thread(process, exit_code);
+		return;
+	}
+
+	// Los threads terminan con el proceso; el que esta corriendo se libera al dejar el CPU
+	for (int i = 0; i < MAX_PROCESSES; i++) {
+		process_t *thread = &processes[i];
+		if (!is_thread(thread) || thread->leader != process
+				|| thread->state == PROCESS_UNUSED || thread->state == PROCESS_ZOMBIE)
+			continue;
+
+		scheduler_unblock(thread);
+		terminate_thread(thread, exit_code);
+		if (thread != scheduler_current())
+			release_thread(thread);
+	}
+
+	// Si murio un thread, el lider puede estar dormido en una wait queue
+	scheduler_unblock(process);
+	process->exit_code = exit_code;
+	process->state = PROCESS_ZOMBIE;
+
+	// Los hijos quedan huerfanos: nadie los va a esperar
+	for (int i = 0; i < MAX_PROCESSES; i++) {
+		process_t *child = &processes[i];
+		if (child->state == PROCESS_UNUSED || is_thread(child) || child->parent_pid != process->pid)
+			continue;
+		child->parent_pid = 0;
+		if (child->state == PROCESS_ZOMBIE && child->space == 0)
+			child->state = PROCESS_UNUSED;
+	}
+
+	process_t *parent = find_process(process->parent_pid);
+	if (parent != 0)
+		wake_group(parent);
+	else
+		process->parent_pid = 0;
+}
+
+// Una excepcion en cualquier thread se lleva a todo el proceso
+void process_kill(process_t *process) {
+	process_t *leader = process->leader;
+	int was_init = leader->pid == init_pid;
+
+	process_terminate(leader, -1);
+	if (was_init)
+		process_create_init();
+}
+
+// Los stacks de threads se materializan on demand salvo la pagina de guarda
+static int in_thread_stack(const process_t *process, uint64_t address) {
+	if (!in_range(address, USER_THREAD_STACKS_START, USER_THREAD_STACKS_END))
+		return 0;
+
+	uint64_t slot = (address - USER_THREAD_STACKS_START) / THREAD_STACK_SIZE;
+	return (process->thread_slots & (1U << slot)) && address >= thread_stack_top(slot) - THREAD_STACK_SIZE + PAGE_SIZE;
+}
+
+static int in_stack(const process_t *process, uint64_t address) {
+	return in_range(address, USER_STACK_TOP - USER_STACK_SIZE, USER_STACK_TOP) || in_thread_stack(process, address);
+}
+
+int process_handle_page_fault(uint64_t address, uint64_t error_code) {
+	if (scheduler_current() == 0)
+		return 0;
+
+	process_t *process = process_current();
+	if (process->space == 0 || process->space == paging_kernel_space())
+		return 0;
+
+	uint64_t page = PAGE_ALIGN_DOWN(address);
+	uint64_t flags = PAGE_WRITABLE | PAGE_USER;
+
+	if (error_code & PF_PRESENT)
+		return (error_code & PF_WRITE) && paging_copy_on_write(process->space, page) == 0;
+
+	const mmap_region_t *region = mmap_find(process, address);
+	if (region != 0) {
+		if (!mmap_handle_fault(process, region, address))
+			return 0;
+		// Una escritura se encontraria con el frame compartido: se copia ya
+		return !(error_code & PF_WRITE) || (paging_flags(process->space, page) & PAGE_WRITABLE)
+				|| paging_copy_on_write(process->space, page) == 0;
+	}
+
+	if (!in_range(address, process->heap_start, PAGE_ALIGN_UP(process->heap_end)) && !in_stack(process, address)) {
+		const bss_region_t *bss = find_bss(process, address);
+		if (bss == 0)
+			return 0;
+		flags = bss->flags;
+	}
+	return map_zeroed(process->space, page, flags);
+}
+
+uint64_t process_pin_page(uint64_t address, int writable) {
+	process_t *process = process_current();
+	uint64_t page = PAGE_ALIGN_DOWN(address);
+
+	// Se provoca lo mismo que haria un acceso: materializar o romper el COW
+	if (!(paging_flags(process->space, page) & PAGE_PRESENT)
+			&& !process_handle_page_fault(page, writable ? PF_WRITE : 0))
+		return 0;
+	if (writable && !(paging_flags(process->space, page) & PAGE_WRITABLE)
+			&& !process_handle_page_fault(page, PF_PRESENT | PF_WRITE))
+		return 0;
+
+	uint64_t frame = paging_translate(process->space, page);
+	pmm_ref_frame(frame);
+	return frame;
+}
+
+//=============================================================================
+// PROCESS SYSCALLS
+//=============================================================================
+
+/*
+ * El hijo retoma con una copia del frame de la syscall del padre, en el tope
+ * de su propio stack de kernel, con rax en 0.
+ */
+int64_t process_fork(void) {
+	process_t *thread = scheduler_current();
+	process_t *parent = process_current();
+	process_t *child = alloc_process();
+	if (child == 0)
+		return -1;
+
+	child->space = paging_fork(parent->space);
+	if (child->space == 0)
+		return -1;
+
+	interrupt_frame_t *frame = (interrupt_frame_t *)process_kernel_stack(child) - 1;
+	memcpy(frame, thread->syscall_frame, sizeof(interrupt_frame_t));
+	frame->registers.rax = 0;
+
+	child->parent_pid = parent->pid;
+	child->rsp = (uint64_t)frame;
+	child->heap_start = parent->heap_start;
+	child->heap_end = parent->heap_end;
+	memcpy(child->bss, parent->bss, sizeof(child->bss));
+	child->bss_count = parent->bss_count;
+	file_inherit(child, parent);
+	memcpy(child->mmaps, parent->mmaps, sizeof(child->mmaps));
+	child->mmap_count = parent->mmap_count;
+	child->console = parent->console;
+	// Si el que hace fork es un thread, el hijo sigue corriendo sobre ese stack
+	if (is_thread(thread))
+		child->thread_slots = 1U << thread->stack_slot;
+	child->state = PROCESS_READY;
+	return child->pid;
+}
+
+static int64_t spawn(const image_t *image) {
+	process_t *child = create_process(image, process_current()->pid);
+	if (child == 0)
+		return -1;
+	child->console = process_current()->console;
+	return child->pid;
+}
+
+int64_t process_spawn(uint32_t module) {
+	image_t image;
+	return build_module_image(module, &image) == 0 ? spawn(&image) : -1;
+}
+
+int64_t process_spawn_file(const char *name) {
+	image_t image;
+	return build_named_image(name, &image) == 0 ? spawn(&image) : -1;
+}
+
+/*
+ * La imagen nueva queda pendiente hasta que el proceso deje de correr sobre
+ * el espacio viejo; ahi el scheduler lo libera y arranca el programa.
+ */
+static int64_t exec(process_t *process, const image_t *image) {
+	set_image(process, image);
+	process->exec_entry = image->entry;
+	process->exec_space = image->space;
+	_yield();
+	return 0;
+}
+
+// Los otros threads se quedarian sin su imagen
+static int can_exec(const process_t *process) {
+	return !is_thread(process) && process->thread_count == 0;
+}
+
+int64_t process_exec(uint32_t module) {
+	process_t *process = scheduler_current();
+	image_t image;
+	return can_exec(process) && build_module_image(module, &image) == 0 ? exec(process, &image) : -1;
+}
+
+int64_t process_exec_file(const char *name) {
+	process_t *process = scheduler_current();
+	image_t image;
+	return can_exec(process) && build_named_image(name, &image) == 0 ? exec(process, &image) : -1;
+}
+
+void process_exit(int64_t exit_code) {
+	process_terminate(scheduler_current(), exit_code);
+	_yield();
+}
+
+int64_t process_wait(int64_t pid, int64_t *status) {
+	process_t *parent = process_current();
+
+	while (1) {
+		int has_children = 0;
+
+		for (int i = 0; i < MAX_PROCESSES; i++) {
+			process_t *child = &processes[i];
+			if (child->state == PROCESS_UNUSED || is_thread(child) || child->parent_pid != parent->pid
+					|| (pid > 0 && child->pid != (uint64_t)pid))
+				continue;
+
+			has_children = 1;
+			if (child->state == PROCESS_ZOMBIE && child->space == 0) {
+				if (status != 0)
+					*status = child->exit_code;
+				child->state = PROCESS_UNUSED;
+				return child->pid;
+			}
+		}
+
+		if (!has_children)
+			return -1;
+		scheduler_block();
+	}
+}
+
+uint64_t process_sbrk(int64_t increment) {
+	process_t *process = process_current();
+	uint64_t old_end = process->heap_end;
+	uint64_t new_end = old_end + increment;
+
+	if (new_end < process->heap_start || new_end > USER_HEAP_END)
+		return (uint64_t)-1;
+
+	// Al achicar se devuelven las paginas que hayan llegado a materializarse
+	for (uint64_t page = PAGE_ALIGN_UP(new_end); page < PAGE_ALIGN_UP(old_end); page += PAGE_SIZE)
+		pmm_free_frame(paging_unmap(process->space, page));
+
+	process->heap_end = new_end;
+	return old_end;
+}
+
+//=============================================================================
+// THREAD SYSCALLS
+//=============================================================================
+
+// El contexto inicial se arma igual que el de un proceso nuevo
+int64_t process_thread_create(uint64_t entry, uint64_t arg0, uint64_t arg1) {
+	process_t *leader = process_current();
+	int slot = 0;
+
+	while (slot < MAX_THREADS && (leader->thread_slots & (1U << slot)))
+		slot++;
+	if (slot == MAX_THREADS)
+		return -1;
+
+	process_t *thread = alloc_process();
+	if (thread == 0)
+		return -1;
+
+	leader->thread_slots |= 1U << slot;
+	interrupt_frame_t *frame = (interrupt_frame_t *)initial_context(thread, entry, thread_stack_top(slot));
+	frame->registers.rdi = arg0;
+	frame->registers.rsi = arg1;
+
+	thread->leader = leader;
+	thread->space = leader->space;
+	thread->stack_slot = slot;
+	thread->rsp = (uint64_t)frame;
+	thread->state = PROCESS_READY;
+	leader->thread_count++;
+	return thread->pid;
+}
+
+int64_t process_thread_join(int64_t tid, int64_t *status) {
+	process_t *self = scheduler_current();
+	process_t *thread = find_process(tid);
+
+	if (thread == 0 || thread == self || !is_thread(thread) || thread->leader != self->leader)
+		return -1;
+
+	while (thread->state != PROCESS_ZOMBIE || thread->space != 0) {
+		self->joining = tid;
+		scheduler_block();
+		self->joining = 0;
+	}
+
+	if (status != 0)
+		*status = thread->exit_code;
+	thread->state = PROCESS_UNUSED;
+	return 0;
+}
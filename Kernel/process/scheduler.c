@@ -0,0 +1,155 @@
+#include <stdint.h>
+#include <scheduler.h>
+#include <process.h>
+#include <paging.h>
+#include <interrupts.h>
+#include <gdtLoader.h>
+
+#define IDLE_STACK_SIZE 0x1000
+
+static process_t *current = 0;
+
+// El proceso idle corre en el espacio del kernel cuando nadie mas esta listo;
+// como los demas, atiende las IRQs en un stack aparte del que usa su codigo
+static process_t idle;
+static uint8_t idle_stack[IDLE_STACK_SIZE] __attribute__((aligned(16)));
+static uint8_t idle_kernel_stack[IDLE_STACK_SIZE] __attribute__((aligned(16)));
+
+static void idle_loop() {
+	while (1)
+		_hlt();
+}
+
+static process_t *pick_next(process_t *previous) {
+	process_t *table = process_table();
+	int start = previous == &idle ? MAX_PROCESSES - 1 : previous - table;
+
+	for (int i = 1; i <= MAX_PROCESSES; i++) {
+		process_t *candidate = &table[(start + i) % MAX_PROCESSES];
+		if (candidate->state == PROCESS_READY)
+			return candidate;
+	}
+
+	return &idle;
+}
+
+static uint64_t switch_to(process_t *next) {
+	current = next;
+	current->state = PROCESS_RUNNING;
+	if (current != &idle) {
+		set_page_fault_stack(process_fault_stack(current));
+		set_kernel_stack(process_kernel_stack(current));
+	} else {
+		set_kernel_stack((uint64_t)(idle_kernel_stack + IDLE_STACK_SIZE));
+	}
+	if (current->space != paging_current())
+		paging_switch(current->space);
+	return current->rsp;
+}
+
+void scheduler_start(void) {
+	interrupt_frame_t *frame = (interrupt_frame_t *)(idle_kernel_stack + IDLE_STACK_SIZE) - 1;
+
+	process_build_frame(frame, (uint64_t)idle_loop, (uint64_t)(idle_stack + IDLE_STACK_SIZE));
+	idle.pid = 0;
+	idle.leader = &idle;
+	idle.space = paging_kernel_space();
+	idle.rsp = (uint64_t)frame;
+
+	_cli();
+	_resumeContext(switch_to(pick_next(&idle)));
+}
+
+process_t *scheduler_current(void) {
+	return current;
+}
+
+void scheduler_block(void) {
+	current->state = PROCESS_BLOCKED;
+	_yield();
+}
+
+// Al final de la cola: scheduler_wake_one despierta en orden de llegada
+void scheduler_wait(wait_queue_t *queue) {
+	process_t **last = &queue->head;
+	while (*last != 0)
+		last = &(*last)->wait_next;
+
+	current->wait_next = 0;
+	current->wait_queue = queue;
+	*last = current;
+	scheduler_block();
+}
+
+static void dequeue(process_t *process) {
+	process_t **link = &process->wait_queue->head;
+	while (*link != 0 && *link != process)
+		link = &(*link)->wait_next;
+	if (*link != 0)
+		*link = process->wait_next;
+	process->wait_next = 0;
+	process->wait_queue = 0;
+}
+
+int scheduler_wake_one(wait_queue_t *queue) {
+	process_t *process = queue->head;
+	if (process == 0)
+		return 0;
+
+	queue->head = process->wait_next;
+	process->wait_next = 0;
+	process->wait_queue = 0;
+	scheduler_unblock(process);
+	return 1;
+}
+
+void scheduler_wake_all(wait_queue_t *queue) {
+	process_t *process = queue->head;
+
+	queue->head = 0;
+	while (process != 0) {
+		process_t *next = process->wait_next;
+		process->wait_next = 0;
+		process->wait_queue = 0;
+		scheduler_unblock(process);
+		process = next;
+	}
+}
+
+// Despertado por otra causa: si quedara en la cola, volver a esperar la dejaria con un ciclo
+void scheduler_unblock(process_t *process) {
+	if (process->wait_queue != 0)
+		dequeue(process);
+	if (process->state == PROCESS_BLOCKED)
+		process->state = PROCESS_READY;
+}
+
+uint64_t schedule(uint64_t rsp) {
+	if (current == 0)
+		return rsp;
+
+	process_t *previous = current;
+	if (previous->exec_space != 0)
+		process_complete_exec(previous);    // su contexto ya apunta a la imagen nueva
+	else
+		previous->rsp = rsp;
+	if (previous->state == PROCESS_RUNNING)
+		previous->state = previous == &idle ? PROCESS_BLOCKED : PROCESS_READY;
+
+	process_t *next = pick_next(previous);
+
+	// Ya no se ejecuta sobre su stack: se puede liberar su memoria
+	if (previous->state == PROCESS_ZOMBIE)
+		process_release(previous);
+
+	return switch_to(next);
+}
+
+uint64_t killCurrentProcess(void) {
+	// Sin proceso al que culpar (boot, idle) no hay forma de seguir
+	while (current == 0 || current == &idle)
+		haltcpu();
+
+	process_kill(current);
+	return schedule(0);
+}
@@ -0,0 +1,89 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "modulePacker.h"
+
+/*
+ * LZ4 block format compressor: greedy, with a single hash table of the last
+ * position where each 4-byte sequence was seen. Sequences follow the format
+ * rules (the last 5 bytes are always literals, no match starts in the last
+ * 12), so any LZ4 block decoder can read the output.
+ */
+#define HASH_BITS 12
+#define MIN_MATCH 4
+#define LAST_LITERALS 5
+#define MATCH_LIMIT 12
+#define MAX_OFFSET 65535
+
+static uint32_t read32(const uint8_t *p) {
+	uint32_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static uint32_t hash(uint32_t sequence) {
+	return (sequence * 2654435761U) >> (32 - HASH_BITS);
+}
+
+static uint8_t *write_length(uint8_t *out, size_t length) {
+	for (; length >= 255; length -= 255)
+		*out++ = 255;
+	*out++ = length;
+	return out;
+}
+
+static uint8_t *write_sequence(uint8_t *out, const uint8_t *literals, size_t literal_length, size_t offset, size_t match_length) {
+	uint8_t *token = out++;
+	size_t match_code = match_length - MIN_MATCH;
+
+	*token = (literal_length >= 15 ? 15 : literal_length) << 4;
+	if (literal_length >= 15)
+		out = write_length(out, literal_length - 15);
+	memcpy(out, literals, literal_length);
+	out += literal_length;
+
+	if (match_length == 0)
+		return out;                 //Last sequence: literals only
+
+	*out++ = offset & 0xFF;
+	*out++ = offset >> 8;
+	*token |= match_code >= 15 ? 15 : match_code;
+	if (match_code >= 15)
+		out = write_length(out, match_code - 15);
+	return out;
+}
+
+size_t lz4_compress(const uint8_t *source, size_t size, uint8_t *destination) {
+	static uint32_t table[1 << HASH_BITS];      //position + 1, 0 if empty
+	uint8_t *out = destination;
+	size_t anchor = 0, position = 0;
+
+	memset(table, 0, sizeof(table));
+
+	if (size > MATCH_LIMIT) {
+		while (position < size - MATCH_LIMIT) {
+			uint32_t sequence = read32(source + position);
+			uint32_t *slot = &table[hash(sequence)];
+			size_t candidate = *slot;
+			*slot = position + 1;
+
+			if (candidate == 0 || position - (candidate - 1) > MAX_OFFSET
+					|| read32(source + candidate - 1) != sequence) {
+				position++;
+				continue;
+			}
+			candidate--;
+
+			size_t length = MIN_MATCH;
+			while (position + length < size - LAST_LITERALS && source[candidate + length] == source[position + length])
+				length++;
+
+			out = write_sequence(out, source + anchor, position - anchor, position - candidate, length);
+			position += length;
+			anchor = position;
+		}
+	}
+
+	out = write_sequence(out, source + anchor, size - anchor, 0, 0);
+	return out - destination;
+}
@@ -1,7 +1,10 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/sendfile.h>
 #include <stdlib.h>
 #include <argp.h>
 
@@ -9,7 +12,7 @@
 
 //Parser elements
 const char *argp_program_version =
-  "x64BareBones ModulePacker (C) v0.2";
+  "x64BareBones ModulePacker (C) v0.3";
 const char *argp_program_bug_address =
   "arq-catedra@googlegroups.com";
 
@@ -24,9 +27,14 @@ static char args_doc[] = "KernelFile Module1 Module2 ...";
 static struct argp_option options[] = {
   {"output",   'o', "FILE", 0,
    "Output to FILE instead of standard output" },
+  {"compress", 'c', 0, 0,
+   "Store modules as LZ4 blocks when that makes them smaller" },
   { 0 }
 };
 
+static error_t
+parse_opt (int key, char *arg, struct argp_state *state);
+
 /* Our argp parser. */
 static struct argp argp = { options, parse_opt, args_doc, doc };
 
@@ -37,6 +45,7 @@ int main(int argc, char *argv[]) {
 
 	arguments.output_file = OUTPUT_FILE;
 	arguments.count = 0;
+	arguments.compress = FALSE;
 
 	argp_parse (&argp, argc, argv, 0, 0, &arguments);
 
@@ -46,42 +55,76 @@ int main(int argc, char *argv[]) {
 		return 1;
 	}	
 
-	return !buildImage(fileArray, arguments.output_file);
+	return !buildImage(fileArray, arguments.output_file, arguments.compress);
 }
 
-int buildImage(array_t fileArray, char *output_file) {
+int buildImage(array_t fileArray, char *output_file, int compress) {
 
-	FILE *target;
+	int target;
+	int sources[MAX_FILES];
+	uint64_t sizes[MAX_FILES];
+	int modules = fileArray.length - 1;
+	module_index_header_t header = {MODULE_INDEX_MAGIC, modules};
+	module_index_entry_t entries[MAX_FILES];
+	int i, ok = TRUE;
 
-	if((target = fopen(output_file, "w")) == NULL) {
+	if((target = open(output_file, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
 		printf("Can't create target file\n");
 		return FALSE;
 	}
 
-	//First, write the kernel
-	FILE *source = fopen(fileArray.array[0], "r");
-	write_file(target, source);
+	for (i = 0 ; i < fileArray.length ; i++) {
+		struct stat st;
+		sources[i] = open(fileArray.array[i], O_RDONLY);
+		fstat(sources[i], &st);
+		sizes[i] = st.st_size;
+	}
 
-	//Write how many extra binaries we got.
-	int extraBinaries = fileArray.length - 1;
-	fwrite(&extraBinaries, sizeof(extraBinaries), 1, target);	
-	fclose(source);
+	//The payload starts right after the kernel, with the index table.
+	//Offsets in the file keep the physical alignment (loaded at 1 MiB).
+	uint64_t payload = sizes[0];
+	uint64_t next = ALIGN_UP(payload + sizeof(header) + modules * sizeof(module_index_entry_t));
 
-	int i;
-	for (i = 1 ; i < fileArray.length ; i++) {
-		FILE *source = fopen(fileArray.array[i], "r");
-		
-		//Write the file size;
-		write_size(target, fileArray.array[i]);
+	memset(entries, 0, sizeof(entries));
+	for (i = 0 ; i < modules ; i++) {
+		module_name(entries[i].name, fileArray.array[i + 1]);
+		entries[i].size = sizes[i + 1];
+		ok = ok && checksum_file(sources[i + 1], sizes[i + 1], &entries[i].checksum);
+	}
 
-		//Write the binary
-		write_file(target, source);
+	//First, write the kernel, then every module on its own page and the index
+	ok = ok && write_file(target, sources[0], sizes[0]);
 
-		fclose(source);
+	for (i = 0 ; i < modules && ok ; i++) {
+		entries[i].offset = next - payload;
+		entries[i].packed_size = entries[i].size;
+		ok = lseek(target, next, SEEK_SET) >= 0
+				&& (compress ? write_compressed(target, sources[i + 1], &entries[i])
+						: write_file(target, sources[i + 1], sizes[i + 1]));
+		next = ALIGN_UP(next + entries[i].packed_size);
 
-	} 
-	fclose(target);
-	return TRUE;
+		if (compress)
+			printf("%s: %lu -> %lu bytes\n", entries[i].name,
+					(unsigned long)entries[i].size, (unsigned long)entries[i].packed_size);
+	}
+
+	ok = ok && pwrite(target, &header, sizeof(header), payload) == sizeof(header);
+	ok = ok && pwrite(target, entries, modules * sizeof(module_index_entry_t), payload + sizeof(header))
+			== modules * sizeof(module_index_entry_t);
+
+	if (compress)
+		printf("Packed image: %lu bytes\n", (unsigned long)next);
+
+	//The gaps left by the seeks read as zeros; this pads the last module
+	ok = ok && ftruncate(target, next) == 0;
+
+	for (i = 0 ; i < fileArray.length ; i++)
+		close(sources[i]);
+	close(target);
+
+	if (!ok)
+		printf("Can't write target file\n");
+	return ok;
 }
 
 
@@ -98,24 +141,109 @@ int checkFiles(array_t fileArray) {
 
 }
 
-int write_size(FILE *target, char *filename) {
-	struct stat st;
-	stat(filename, &st);
-	uint32_t size = st.st_size;
-	fwrite(&size, sizeof(uint32_t), 1, target);
+//Name in the index: file name without directory nor extension
+void module_name(char *name, const char *path) {
+	const char *base = strrchr(path, '/');
+	base = base != NULL ? base + 1 : path;
+
+	const char *extension = strrchr(base, '.');
+	size_t length = extension != NULL && extension != base ? (size_t)(extension - base) : strlen(base);
+	if (length >= MODULE_NAME_LENGTH)
+		length = MODULE_NAME_LENGTH - 1;
+
+	memcpy(name, base, length);
+	name[length] = 0;
 }
 
 
-int write_file(FILE *target, FILE *source) {
-	char buffer[BUFFER_SIZE];
-	int read;
+static uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t length) {
+	static uint32_t table[256];
+	static int initialized = FALSE;
 
-	while (!feof(source)) {
-		read = fread(buffer, 1, BUFFER_SIZE, source);
-		fwrite(buffer, 1, read, target);
+	if (!initialized) {
+		uint32_t i, j;
+		for (i = 0; i < 256; i++) {
+			uint32_t value = i;
+			for (j = 0; j < 8; j++)
+				value = value & 1 ? (value >> 1) ^ 0xEDB88320 : value >> 1;
+			table[i] = value;
+		}
+		initialized = TRUE;
 	}
 
-	return TRUE;
+	while (length--)
+		crc = table[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+	return crc;
+}
+
+
+int checksum_file(int source, uint64_t size, uint32_t *checksum) {
+	uint8_t *buffer = malloc(BUFFER_SIZE);
+	uint32_t crc = 0xFFFFFFFF;
+	uint64_t done = 0;
+
+	while (buffer != NULL && done < size) {
+		ssize_t read = pread(source, buffer, BUFFER_SIZE, done);
+		if (read <= 0)
+			break;
+		crc = crc32_update(crc, buffer, read);
+		done += read;
+	}
+
+	free(buffer);
+	*checksum = crc ^ 0xFFFFFFFF;
+	return done == size;
+}
+
+
+//Stores the module as an LZ4 block, unless that does not make it smaller
+int write_compressed(int target, int source, module_index_entry_t *entry) {
+	uint8_t *data = malloc(entry->size + 1);
+	uint8_t *packed = malloc(LZ4_BOUND(entry->size));
+	int ok = data != NULL && packed != NULL
+			&& pread(source, data, entry->size, 0) == (ssize_t)entry->size;
+
+	if (ok) {
+		size_t packed_size = lz4_compress(data, entry->size, packed);
+		if (packed_size < entry->size) {
+			entry->flags |= MODULE_LZ4;
+			entry->packed_size = packed_size;
+			ok = write(target, packed, packed_size) == (ssize_t)packed_size;
+		} else {
+			ok = write(target, data, entry->size) == (ssize_t)entry->size;
+		}
+	}
+
+	free(data);
+	free(packed);
+	return ok;
+}
+
+
+//The kernel copies the data (sendfile); if it can't, large buffers do
+int write_file(int target, int source, uint64_t size) {
+	off_t offset = 0;
+
+	while ((uint64_t)offset < size) {
+		ssize_t sent = sendfile(target, source, &offset, size - offset);
+		if (sent <= 0)
+			break;
+	}
+
+	if ((uint64_t)offset < size) {
+		char *buffer = malloc(BUFFER_SIZE);
+		ssize_t read;
+
+		while (buffer != NULL && (uint64_t)offset < size
+				&& (read = pread(source, buffer, BUFFER_SIZE, offset)) > 0) {
+			if (write(target, buffer, read) != read)
+				break;
+			offset += read;
+		}
+		free(buffer);
+	}
+
+	return (uint64_t)offset == size;
 }
 
 
@@ -133,7 +261,13 @@ parse_opt (int key, char *arg, struct argp_state *state)
       arguments->output_file = arg;
       break;
 
+    case 'c':
+      arguments->compress = TRUE;
+      break;
+
     case ARGP_KEY_ARG:
+      if (state->arg_num >= MAX_FILES)
+        argp_error (state, "too many modules, the kernel loads at most %d", MAX_MODULES);
       arguments->args[state->arg_num] = arg;
       break;
 
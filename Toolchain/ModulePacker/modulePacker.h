@@ -2,16 +2,49 @@
 #define _MODULE_PACKER_H_
 
 #include <argp.h>
+#include <stdint.h>
 
 
 #define FALSE 0
 #define TRUE !FALSE
 
-#define BUFFER_SIZE 128
+#define BUFFER_SIZE (1 << 20)
+
+// The image is loaded at 1 MiB, so file offsets keep the physical alignment
+#define PAGE_ALIGNMENT 4096
+#define ALIGN_UP(x) (((x) + PAGE_ALIGNMENT - 1) & ~(uint64_t)(PAGE_ALIGNMENT - 1))
 
 #define OUTPUT_FILE "packedKernel.bin"
 
-#define MAX_FILES 128
+// Must match MAX_MODULES in Kernel/include/moduleLoader.h: the kernel drops the rest
+#define MAX_MODULES 32
+#define MAX_FILES (MAX_MODULES + 1)         // the kernel and its modules
+
+// Index table at the start of the payload (right after the kernel)
+#define MODULE_INDEX_MAGIC 0x53444F4D      // "MODS"
+#define MODULE_NAME_LENGTH 32
+#define MODULE_LZ4 0x1                      // stored as an LZ4 block
+
+// Worst case of an LZ4 block (incompressible data)
+#define LZ4_BOUND(size) ((size) + (size) / 255 + 16)
+
+#pragma pack(push, 1)
+
+typedef struct {
+	uint32_t magic;
+	uint32_t count;
+} module_index_header_t;
+
+typedef struct {
+	char name[MODULE_NAME_LENGTH];          // file name without directory nor extension
+	uint64_t offset;                        // from the start of the payload, page aligned
+	uint64_t size;                          // once decompressed
+	uint64_t packed_size;                   // bytes stored in the payload
+	uint32_t checksum;                      // CRC-32 of the (decompressed) module
+	uint32_t flags;
+} module_index_entry_t;
+
+#pragma pack(pop)
 
 
 typedef struct {
@@ -24,22 +57,25 @@ typedef struct {
 struct arguments
 {
   char *args[MAX_FILES];                
-  int silent, verbose;
+  int silent, verbose, compress;
   char *output_file;
   int count;
 };
 
 
-int buildImage(array_t fileArray, char *output_file);
+int buildImage(array_t fileArray, char *output_file, int compress);
 
-int write_size(FILE *target, char *filename);
+int write_file(int target, int source, uint64_t size);
 
-int write_file(FILE *target, FILE *source);
+int checksum_file(int source, uint64_t size, uint32_t *checksum);
 
-int checkFiles(array_t fileArray);
+void module_name(char *name, const char *path);
 
-static error_t
-parse_opt (int key, char *arg, struct argp_state *state);
+int write_compressed(int target, int source, module_index_entry_t *entry);
+
+size_t lz4_compress(const uint8_t *source, size_t size, uint8_t *destination);
+
+int checkFiles(array_t fileArray);
 
 
 #endif
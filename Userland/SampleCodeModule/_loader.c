@@ -1,28 +1,12 @@
 /* _loader.c */
 #include <stdint.h>
-
-extern char bss;
-extern char endOfBinary;
+#include "syscalls.h"
 
 int main();
 
-void * memset(void * destiny, int32_t c, uint64_t length);
-
+// El kernel entrega el .bss en cero (se materializa al tocarlo)
 int _start() {
-	//Clean BSS
-	memset(&bss, 0, &endOfBinary - &bss);
-
-	return main();
-
-}
-
-
-void * memset(void * destiation, int32_t c, uint64_t length) {
-	uint8_t chr = (uint8_t)c;
-	char * dst = (char*)destiation;
-
-	while(length--)
-		dst[length] = chr;
+	sys_exit(main());
+	return 0;
 
-	return destiation;
 }
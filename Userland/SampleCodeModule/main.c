@@ -1,6 +1,14 @@
 #include "syscalls.h"
+#include "pipeBenchmark.h"
+#include "memoryTests.h"
 
 int main() {
   sys_write(1, "Hello, World!\n", 13);
+#ifdef MEMORY_TESTS
+  memory_tests();
+#endif
+#ifdef PIPE_BENCHMARK
+  pipe_benchmark();
+#endif
   return 0;
 }
@@ -0,0 +1,269 @@
+#include <stdint.h>
+#include "syscalls.h"
+#include "memoryTests.h"
+#include "thread.h"
+#include "taskPool.h"
+
+#define PAGE_SIZE 0x1000
+#define SELF_MODULE 0                   // este programa es el modulo de init
+#define SELF_NAME "0000-sampleCodeModule"   // su nombre en el indice del payload
+#define BOOT_INIT_PID 1                 // el init del arranque: el resto son spawns del test
+#define SPAWN_PRISTINE 0x1234
+#define PIPE_PATTERN 0x5A
+#define GROUP_EXIT_CODE 7
+#define POOL_TEST_WORKERS 4
+#define POOL_TEST_SIZE 4096
+#define MMAP_TEST_FILE "mmaptest.bin"   // se carga con: bmfs <imagen> create/write
+
+static uint64_t length(const char *s) {
+  uint64_t n = 0;
+  while (s[n] != 0)
+    n++;
+  return n;
+}
+
+static void print(const char *s) {
+  sys_write(1, s, length(s));
+}
+
+static void report(const char *name, int passed) {
+  print(passed ? "PASS " : "FAIL ");
+  print(name);
+  print("\n");
+}
+
+//=============================================================================
+// FORK
+//=============================================================================
+
+static volatile uint64_t fork_global = 1;
+
+// El hijo escribe sus copias de .data, heap y stack; las del padre no cambian
+static void test_fork(void) {
+  uint64_t *heap = (uint64_t *)sys_sbrk(PAGE_SIZE);
+  volatile uint64_t local = 1;
+  int64_t status = -1;
+
+  *heap = 1;
+  int64_t child = sys_fork();
+  if (child == 0) {
+    fork_global = 2;
+    *heap = 2;
+    local = 2;
+    sys_exit(fork_global == 2 && *heap == 2 && local == 2 ? 0 : 1);
+  }
+
+  sys_waitpid(child, &status);
+  report("fork: the child's writes stay in the child",
+         child > 0 && status == 0 && fork_global == 1 && *heap == 1 && local == 1);
+}
+
+//=============================================================================
+// SPAWN
+//=============================================================================
+
+// Con valor inicial: vive en .data, que se mapea desde los frames del modulo
+static volatile uint64_t spawn_global = SPAWN_PRISTINE;
+
+/*
+ * Un spawn arranca de la imagen del modulo, sin nada del padre: la copia que
+ * lanza el test se reconoce por no ser el init del arranque. Informa en su
+ * exit code si su .data estaba intacto, lo ensucia y termina.
+ */
+static void run_if_spawned(void) {
+  if (sys_getpid() == BOOT_INIT_PID)
+    return;
+
+  int pristine = spawn_global == SPAWN_PRISTINE;
+  spawn_global = 0;
+  sys_exit(pristine ? 0 : 1);
+}
+
+// El programa en curso y el primer hijo escriben el global antes del segundo spawn
+static void test_spawn(void) {
+  int64_t status[2] = { -1, -1 };
+
+  spawn_global = 0;
+  for (int i = 0; i < 2; i++)
+    sys_waitpid(sys_spawn(SELF_MODULE), &status[i]);
+
+  report("spawn: every run starts from the module's clean image", status[0] == 0 && status[1] == 0);
+}
+
+// El hijo de un fork ensucia su copia y se reemplaza por el programa buscado por nombre
+static void test_exec_file(void) {
+  int64_t status = -1;
+
+  int64_t child = sys_fork();
+  if (child == 0) {
+    spawn_global = 0;
+    sys_exec_file(SELF_NAME);
+    sys_exit(2);
+  }
+
+  sys_waitpid(child, &status);
+  report("exec: by name replaces the image with the module's clean one", child > 0 && status == 0);
+}
+
+//=============================================================================
+// MMAP
+//=============================================================================
+
+/*
+ * Un mmap privado comparte los frames del block cache: escribirlo tiene que
+ * copiar la pagina, sin que cambie lo que ven read ni otro mmap del archivo.
+ */
+static void test_private_mmap(void) {
+  int64_t fd = sys_open(MMAP_TEST_FILE);
+  if (fd < 0) {
+    print("SKIP mmap: no " MMAP_TEST_FILE " on the disk\n");
+    return;
+  }
+
+  volatile uint8_t *private = sys_mmap(fd, 0, PAGE_SIZE, MMAP_WRITABLE);
+  if (private == 0) {
+    sys_close(fd);
+    print("SKIP mmap: " MMAP_TEST_FILE " could not be mapped\n");
+    return;
+  }
+
+  uint8_t original = private[0];
+  uint8_t changed = ~original;
+  private[0] = changed;
+
+  char byte = changed;
+  sys_seek(fd, 0);
+  uint64_t count = sys_read(fd, &byte, 1);
+  volatile uint8_t *shared = sys_mmap(fd, 0, PAGE_SIZE, 0);
+
+  report("mmap: private writes reach neither the file nor other mappings",
+         private[0] == changed && count == 1 && (uint8_t)byte == original
+         && shared != 0 && shared[0] == original);
+  if (shared != 0)
+    sys_munmap((void *)shared);
+  sys_munmap((void *)private);
+  sys_close(fd);
+}
+
+//=============================================================================
+// PIPES
+//=============================================================================
+
+// Paginas alineadas en el heap: el modo zero-copy solo pasa paginas enteras
+static uint8_t *alloc_pages(uint64_t pages) {
+  uint64_t end = (uint64_t)sys_sbrk(0);
+  uint64_t padding = (PAGE_SIZE - end % PAGE_SIZE) % PAGE_SIZE;
+  return (uint8_t *)sys_sbrk(padding + pages * PAGE_SIZE) + padding;
+}
+
+/*
+ * El hijo manda por un pipe zero-copy su copia de una pagina que comparte
+ * con el padre desde el fork. El padre la recibe copy-on-write en otro
+ * buffer: escribirlo no puede cambiar su pagina original.
+ */
+static void test_zero_copy_pipe(void) {
+  uint8_t *pages = alloc_pages(2);
+  volatile uint8_t *sent = pages;
+  volatile uint8_t *received = pages + PAGE_SIZE;
+  int64_t fds[2];
+
+  if (sys_pipe(fds, PIPE_ZERO_COPY) != 0) {
+    print("SKIP pipe: no free pipe\n");
+    return;
+  }
+
+  for (int i = 0; i < PAGE_SIZE; i++)
+    sent[i] = PIPE_PATTERN;
+
+  int64_t child = sys_fork();
+  if (child == 0) {
+    sys_close(fds[0]);
+    sys_write(fds[1], (const char *)sent, PAGE_SIZE);
+    sys_exit(0);
+  }
+
+  sys_close(fds[1]);
+  uint64_t count = sys_read(fds[0], (char *)received, PAGE_SIZE);
+  sys_close(fds[0]);
+  sys_waitpid(child, 0);
+
+  int passed = count == PAGE_SIZE && received[0] == PIPE_PATTERN;
+  received[0] = 0;
+  report("pipe: writing a zero-copy page leaves the sender's copy alone",
+         passed && received[0] == 0 && sent[0] == PIPE_PATTERN);
+}
+
+//=============================================================================
+// THREADS
+//=============================================================================
+
+static int64_t spin(void *arg) {
+  while (1)
+    sys_yield();
+  return 0;
+}
+
+// Si el proceso termina, su thread termina con el: si no, el padre lo esperaria para siempre
+static void test_thread_group_exit(void) {
+  int64_t status = -1;
+
+  int64_t child = sys_fork();
+  if (child == 0) {
+    thread_create(spin, 0);
+    sys_exit(GROUP_EXIT_CODE);
+  }
+
+  sys_waitpid(child, &status);
+  report("threads: exiting the process ends its threads too", child > 0 && status == GROUP_EXIT_CODE);
+}
+
+//=============================================================================
+// TASK POOL
+//=============================================================================
+
+static uint64_t squares[POOL_TEST_SIZE];
+
+static void square_range(uint64_t begin, uint64_t end, void *arg) {
+  for (uint64_t i = begin; i < end; i++)
+    squares[i] = i * i;
+}
+
+static int64_t sum_squares(void *arg) {
+  int64_t sum = 0;
+  for (uint64_t i = 0; i < POOL_TEST_SIZE; i++)
+    sum += squares[i];
+  return sum;
+}
+
+/*
+ * parallel_for reparte el arreglo entre los workers y una tarea suelta lo
+ * suma; el pool es lo ultimo del heap, asi que destruirlo devuelve el break.
+ */
+static void test_task_pool(void) {
+  void *heap_end = sys_sbrk(0);
+  pool_t *pool = pool_create(POOL_TEST_WORKERS);
+  if (pool == 0) {
+    print("SKIP pool: the workers could not be created\n");
+    return;
+  }
+
+  parallel_for(pool, 0, POOL_TEST_SIZE, 0, square_range, 0);
+  task_t *task = pool_submit(pool, sum_squares, 0);
+  int64_t sum = task != 0 ? task_join(pool, task) : -1;
+  pool_destroy(pool);
+
+  int64_t n = POOL_TEST_SIZE;
+  report("pool: parallel_for and task_join see every chunk, destroy returns the heap",
+         sum == (n - 1) * n * (2 * n - 1) / 6 && sys_sbrk(0) == heap_end);
+}
+
+void memory_tests(void) {
+  run_if_spawned();
+  test_fork();
+  test_spawn();
+  test_exec_file();
+  test_private_mmap();
+  test_zero_copy_pipe();
+  test_thread_group_exit();
+  test_task_pool();
+}
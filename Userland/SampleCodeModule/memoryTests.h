@@ -0,0 +1,10 @@
+#ifndef MEMORY_TESTS_H
+#define MEMORY_TESTS_H
+
+/**
+ * Checks that memory the kernel shares copy-on-write stays private to each
+ * process, and prints one PASS or FAIL line per test.
+ */
+void memory_tests(void);
+
+#endif
@@ -0,0 +1,91 @@
+#include <stdint.h>
+#include "syscalls.h"
+#include "pipeBenchmark.h"
+
+#define PAGE_SIZE 0x1000
+#define CHUNK_SIZE 0x10000                // 64 KiB por write/read
+#define TOTAL_SIZE 0x4000000              // 64 MiB por corrida
+
+static uint64_t length(const char *s) {
+  uint64_t n = 0;
+  while (s[n] != 0)
+    n++;
+  return n;
+}
+
+static void print(const char *s) {
+  sys_write(1, s, length(s));
+}
+
+static void print_dec(uint64_t value) {
+  char buffer[21];
+  int i = sizeof(buffer) - 1;
+
+  buffer[i] = 0;
+  do {
+    buffer[--i] = '0' + value % 10;
+    value /= 10;
+  } while (value != 0);
+  print(&buffer[i]);
+}
+
+// El buffer alineado a pagina en el heap: asi el modo zero-copy puede pasar paginas
+static uint8_t *alloc_chunk(void) {
+  uint64_t end = (uint64_t)sys_sbrk(0);
+  uint64_t padding = (PAGE_SIZE - end % PAGE_SIZE) % PAGE_SIZE;
+  return (uint8_t *)sys_sbrk(padding + CHUNK_SIZE) + padding;
+}
+
+// Se toca un byte por pagina de cada lado: producir y consumir los datos
+static void consume(int64_t fd, uint8_t *buffer) {
+  int64_t count;
+  uint64_t sum = 0;
+
+  while ((count = sys_read(fd, (char *)buffer, CHUNK_SIZE)) > 0)
+    for (int64_t i = 0; i < count; i += PAGE_SIZE)
+      sum += buffer[i];
+  sys_exit(sum != 0 ? 0 : 1);
+}
+
+static void produce(int64_t fd, uint8_t *buffer) {
+  for (uint64_t sent = 0; sent < TOTAL_SIZE; sent += CHUNK_SIZE) {
+    for (uint64_t i = 0; i < CHUNK_SIZE; i += PAGE_SIZE)
+      buffer[i] = 1;
+    sys_write(fd, (const char *)buffer, CHUNK_SIZE);
+  }
+}
+
+static void run(const char *name, uint64_t flags, uint8_t *buffer) {
+  int64_t fds[2];
+
+  if (sys_pipe(fds, flags) != 0) {
+    print("pipe failed\n");
+    return;
+  }
+
+  uint64_t start = sys_clock();
+  int64_t child = sys_fork();
+  if (child == 0) {
+    sys_close(fds[1]);
+    consume(fds[0], buffer);
+  }
+
+  sys_close(fds[0]);
+  produce(fds[1], buffer);
+  sys_close(fds[1]);
+  sys_waitpid(child, 0);
+  uint64_t elapsed = sys_clock() - start;
+
+  print(name);
+  print(": ");
+  print_dec(elapsed != 0 ? TOTAL_SIZE / elapsed : 0);      // bytes/us = MB/s
+  print(" MB/s\n");
+}
+
+void pipe_benchmark(void) {
+  uint8_t *buffer = alloc_chunk();
+
+  print("Pipe throughput, 64 MiB in 64 KiB writes (one CPU: both ends share it)\n");
+  run("  copy", 0, buffer);
+  run("  zero-copy", PIPE_ZERO_COPY, buffer);
+}
@@ -0,0 +1,10 @@
+#ifndef PIPE_BENCHMARK_H
+#define PIPE_BENCHMARK_H
+
+/**
+ * Measures the throughput of a pipe between a parent and a forked child,
+ * copying and in zero-copy mode, and prints it in MB/s.
+ */
+void pipe_benchmark(void);
+
+#endif
@@ -0,0 +1,48 @@
+#include <stdint.h>
+#include "syscalls.h"
+#include "sync.h"
+
+/*
+ * Mutex de tres estados (Drepper, "Futexes Are Tricky"): solo se entra al
+ * kernel para dormir o si puede haber alguien durmiendo.
+ */
+static uint32_t compare_exchange(uint32_t *word, uint32_t expected, uint32_t desired) {
+  __atomic_compare_exchange_n(word, &expected, desired, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+  return expected;
+}
+
+void mutex_lock(mutex_t *mutex) {
+  uint32_t state = compare_exchange(&mutex->state, 0, 1);
+  if (state == 0)
+    return;
+
+  if (state != 2)
+    state = __atomic_exchange_n(&mutex->state, 2, __ATOMIC_ACQUIRE);
+  while (state != 0) {
+    sys_futex_wait(&mutex->state, 2);
+    state = __atomic_exchange_n(&mutex->state, 2, __ATOMIC_ACQUIRE);
+  }
+}
+
+void mutex_unlock(mutex_t *mutex) {
+  if (__atomic_exchange_n(&mutex->state, 0, __ATOMIC_RELEASE) == 2)
+    sys_futex_wake(&mutex->state, 1);
+}
+
+void cond_wait(cond_t *cond, mutex_t *mutex) {
+  uint32_t sequence = __atomic_load_n(&cond->sequence, __ATOMIC_RELAXED);
+
+  mutex_unlock(mutex);
+  sys_futex_wait(&cond->sequence, sequence);
+  mutex_lock(mutex);
+}
+
+void cond_signal(cond_t *cond) {
+  __atomic_add_fetch(&cond->sequence, 1, __ATOMIC_RELEASE);
+  sys_futex_wake(&cond->sequence, 1);
+}
+
+void cond_broadcast(cond_t *cond) {
+  __atomic_add_fetch(&cond->sequence, 1, __ATOMIC_RELEASE);
+  sys_futex_wake(&cond->sequence, (uint64_t)-1);
+}
@@ -0,0 +1,51 @@
+#ifndef SYNC_H
+#define SYNC_H
+
+#include <stdint.h>
+
+// 0 libre, 1 tomado, 2 tomado con alguien esperando
+typedef struct {
+    uint32_t state;
+} mutex_t;
+
+typedef struct {
+    uint32_t sequence;                  // cambia en cada signal/broadcast
+} cond_t;
+
+#define MUTEX_INITIALIZER {0}
+#define COND_INITIALIZER {0}
+
+/**
+ * Takes a mutex. Without contention it never enters the kernel.
+ * Works across processes when the mutex lives in shared memory.
+ * @param mutex Mutex to take
+ */
+void mutex_lock(mutex_t *mutex);
+
+/**
+ * Releases a mutex, waking one waiter if there is any.
+ * @param mutex Mutex held by the caller
+ */
+void mutex_unlock(mutex_t *mutex);
+
+/**
+ * Releases the mutex, sleeps until the condition is signaled and takes the
+ * mutex again. Wakeups may be spurious: callers re-check their condition.
+ * @param cond Condition variable
+ * @param mutex Mutex held by the caller
+ */
+void cond_wait(cond_t *cond, mutex_t *mutex);
+
+/**
+ * Wakes one process waiting on a condition variable.
+ * @param cond Condition variable
+ */
+void cond_signal(cond_t *cond);
+
+/**
+ * Wakes every process waiting on a condition variable.
+ * @param cond Condition variable
+ */
+void cond_broadcast(cond_t *cond);
+
+#endif
@@ -1,5 +1,41 @@
 GLOBAL sys_read
 GLOBAL sys_write
+GLOBAL sys_exit
+GLOBAL sys_fork
+GLOBAL sys_getpid
+GLOBAL sys_waitpid
+GLOBAL sys_yield
+GLOBAL sys_sbrk
+GLOBAL sys_spawn
+GLOBAL sys_exec
+GLOBAL sys_open
+GLOBAL sys_close
+GLOBAL sys_seek
+GLOBAL sys_fsize
+GLOBAL sys_spawn_file
+GLOBAL sys_aio_read
+GLOBAL sys_aio_write
+GLOBAL sys_aio_wait
+GLOBAL sys_mmap
+GLOBAL sys_munmap
+GLOBAL sys_boot_trace
+GLOBAL sys_pipe
+GLOBAL sys_clock
+GLOBAL sys_shm_create
+GLOBAL sys_shm_map
+GLOBAL sys_shm_destroy
+GLOBAL sys_futex_wait
+GLOBAL sys_futex_wake
+GLOBAL sys_thread_create
+GLOBAL sys_thread_join
+GLOBAL sys_gettid
+GLOBAL sys_fb_map
+GLOBAL sys_fb_present
+GLOBAL sys_gfx_submit
+GLOBAL sys_video_mode
+GLOBAL sys_fb_flip
+GLOBAL sys_set_console
+GLOBAL sys_exec_file
 
 section .text
 
@@ -20,4 +56,112 @@ sys_read:
     syscall 0
 
 sys_write:
-    syscall 1
\ No newline at end of file
+    syscall 1
+
+sys_exit:
+    syscall 2
+
+sys_fork:
+    syscall 3
+
+sys_getpid:
+    syscall 4
+
+sys_waitpid:
+    syscall 5
+
+sys_yield:
+    syscall 6
+
+sys_sbrk:
+    syscall 7
+
+sys_spawn:
+    syscall 8
+
+sys_exec:
+    syscall 9
+
+sys_open:
+    syscall 10
+
+sys_close:
+    syscall 11
+
+sys_seek:
+    syscall 12
+
+sys_fsize:
+    syscall 13
+
+sys_spawn_file:
+    syscall 14
+
+sys_aio_read:
+    syscall 15
+
+sys_aio_write:
+    syscall 16
+
+sys_aio_wait:
+    syscall 17
+
+sys_mmap:
+    syscall 18
+
+sys_munmap:
+    syscall 19
+
+sys_boot_trace:
+    syscall 20
+
+sys_pipe:
+    syscall 21
+
+sys_clock:
+    syscall 22
+
+sys_shm_create:
+    syscall 23
+
+sys_shm_map:
+    syscall 24
+
+sys_shm_destroy:
+    syscall 25
+
+sys_futex_wait:
+    syscall 26
+
+sys_futex_wake:
+    syscall 27
+
+sys_thread_create:
+    syscall 28
+
+sys_thread_join:
+    syscall 29
+
+sys_gettid:
+    syscall 30
+
+sys_fb_map:
+    syscall 31
+
+sys_fb_present:
+    syscall 32
+
+sys_gfx_submit:
+    syscall 33
+
+sys_video_mode:
+    syscall 34
+
+sys_fb_flip:
+    syscall 35
+
+sys_set_console:
+    syscall 36
+
+sys_exec_file:
+    syscall 37
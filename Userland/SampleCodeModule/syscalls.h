@@ -3,8 +3,130 @@
 
 #include <stdint.h>
 
+#define MMAP_WRITABLE 0x1               // sys_mmap: copia privada
+#define PIPE_ZERO_COPY 0x1              // sys_pipe: las paginas enteras del heap se regalan
+
+#define FB_MAP_BACK_BUFFER 0x1          // sys_fb_map: buffer privado, se muestra con sys_fb_present
+
+// sys_fb_map: geometria y formato de los pixeles
+typedef struct {
+    uint64_t address;                   // direccion fisica
+    uint32_t width;
+    uint32_t height;
+    uint32_t pitch;                     // bytes por linea
+    uint32_t bpp;
+    uint32_t red_mask;
+    uint32_t green_mask;
+    uint32_t blue_mask;
+    uint32_t pages;                     // pantallas que entran en la memoria de video (sys_fb_flip)
+} framebuffer_info_t;
+
+// sys_gfx_submit: tipos de comando
+#define GFX_FILL_RECT 0                 // rectangulo de un color
+#define GFX_BLIT 1                      // bitmap de pixeles 0xRRGGBB
+#define GFX_GLYPHS 2                    // tira de caracteres de la fuente
+#define GFX_LINE 3                      // linea de (x, y) a (x2, y2)
+#define GFX_COPY_RECT 4                 // mueve un rectangulo de la pantalla a (x, y)
+
+// sys_gfx_submit: un comando de dibujo, lo que cae fuera de la pantalla se recorta
+typedef struct {
+    uint32_t type;                      // GFX_*
+    uint32_t color;                     // 0xRRGGBB
+    int32_t x;
+    int32_t y;
+    uint32_t width;
+    uint32_t height;
+    union {
+        struct { int32_t x2, y2; } line;
+        struct { int32_t src_x, src_y; } copy;
+        struct { const uint32_t *pixels; uint32_t stride; } blit;                  // stride en pixeles
+        struct { const char *text; uint32_t length; uint32_t scale; } glyphs;     // scale 0: tamano de fuente actual
+    } args;
+} gfx_command_t;
+
+// sys_boot_trace: un punto del arranque, como lo registra el kernel
+typedef struct {
+    char name[24];
+    uint64_t tsc;
+    uint64_t microseconds;              // desde el primer punto registrado
+} boot_trace_record_t;
+
 uint64_t sys_read(uint64_t fd, char *buf, uint64_t count);
 
 uint64_t sys_write(uint64_t fd, const char *buf, uint64_t count);
 
+uint64_t sys_exit(int64_t code);
+
+int64_t sys_fork(void);
+
+uint64_t sys_getpid(void);
+
+int64_t sys_waitpid(int64_t pid, int64_t *status);
+
+uint64_t sys_yield(void);
+
+void *sys_sbrk(int64_t increment);
+
+int64_t sys_spawn(uint64_t module);
+
+int64_t sys_exec(uint64_t module);
+
+int64_t sys_open(const char *name);
+
+int64_t sys_close(uint64_t fd);
+
+int64_t sys_seek(uint64_t fd, uint64_t offset);
+
+int64_t sys_fsize(uint64_t fd);
+
+int64_t sys_spawn_file(const char *name);
+
+int64_t sys_aio_read(uint64_t fd, void *buf, uint64_t count);
+
+int64_t sys_aio_write(uint64_t fd, const void *buf, uint64_t count);
+
+int64_t sys_aio_wait(int64_t id);
+
+void *sys_mmap(uint64_t fd, uint64_t offset, uint64_t length, uint64_t flags);
+
+int64_t sys_munmap(void *address);
+
+uint64_t sys_boot_trace(boot_trace_record_t *buffer, uint64_t max);
+
+int64_t sys_pipe(int64_t fds[2], uint64_t flags);
+
+uint64_t sys_clock(void);
+
+int64_t sys_shm_create(uint64_t size);
+
+void *sys_shm_map(int64_t id);
+
+int64_t sys_shm_destroy(int64_t id);
+
+int64_t sys_futex_wait(uint32_t *address, uint32_t expected);
+
+int64_t sys_futex_wake(uint32_t *address, uint64_t count);
+
+int64_t sys_thread_create(void *entry, uint64_t arg0, uint64_t arg1);
+
+int64_t sys_thread_join(int64_t tid, int64_t *status);
+
+uint64_t sys_gettid(void);
+
+void *sys_fb_map(framebuffer_info_t *info, uint64_t flags);
+
+uint64_t sys_fb_present(const void *buffer);
+
+uint64_t sys_gfx_submit(const gfx_command_t *commands, uint64_t count);
+
+int64_t sys_video_mode(uint64_t width, uint64_t height, uint64_t bpp);
+
+int64_t sys_fb_flip(uint64_t page);
+
+// Consola virtual (0 a 3) donde escriben fd 1 y 2; la heredan fork y spawn
+int64_t sys_set_console(uint64_t console);
+
+// Como sys_exec, pero busca el programa por nombre igual que sys_spawn_file
+int64_t sys_exec_file(const char *name);
+
 #endif
\ No newline at end of file
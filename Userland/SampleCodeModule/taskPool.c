@@ -0,0 +1,315 @@
+#include <stdint.h>
+#include "syscalls.h"
+#include "sync.h"
+#include "thread.h"
+#include "taskPool.h"
+
+struct task {
+  task_function_t function;
+  void *arg;
+  int64_t result;
+  uint32_t done;                        // futex: 1 cuando termino
+  struct task *next_free;
+};
+
+// El dueno saca de bottom (LIFO, datos calientes); los demas roban de top
+typedef struct {
+  mutex_t lock;
+  uint64_t top;
+  uint64_t bottom;
+  task_t *tasks[POOL_DEQUE_SIZE];
+} deque_t;
+
+typedef struct {
+  struct pool *pool;
+  int index;
+} worker_t;
+
+struct pool {
+  int worker_count;
+  worker_t workers[POOL_MAX_WORKERS];
+  int64_t tids[POOL_MAX_WORKERS];
+  deque_t deques[POOL_MAX_WORKERS + 1]; // el ultimo es de los threads que no son workers
+  uint32_t work;                        // futex: cambia con cada tarea nueva
+  uint32_t sleeping;
+  uint32_t stop;
+  mutex_t free_lock;
+  task_t *free_tasks;
+  uint64_t padding;                     // relleno que se pidio a sbrk antes del pool
+  struct pool *next_free;
+  task_t tasks[POOL_MAX_TASKS];
+};
+
+// Pools destruidos que no quedaron al final del heap: los reusa pool_create
+static pool_t *free_pools = 0;
+
+//=============================================================================
+// DEQUES
+//=============================================================================
+
+static int push(deque_t *deque, task_t *task) {
+  int pushed = 0;
+
+  mutex_lock(&deque->lock);
+  if (deque->bottom - deque->top < POOL_DEQUE_SIZE) {
+    deque->tasks[deque->bottom++ % POOL_DEQUE_SIZE] = task;
+    pushed = 1;
+  }
+  mutex_unlock(&deque->lock);
+  return pushed;
+}
+
+static task_t *pop(deque_t *deque) {
+  task_t *task = 0;
+
+  mutex_lock(&deque->lock);
+  if (deque->bottom != deque->top)
+    task = deque->tasks[--deque->bottom % POOL_DEQUE_SIZE];
+  mutex_unlock(&deque->lock);
+  return task;
+}
+
+static task_t *steal(deque_t *deque) {
+  task_t *task = 0;
+
+  // Sin tomar el lock si se ve vacia: es lo mas comun al buscar trabajo
+  if (__atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) == __atomic_load_n(&deque->top, __ATOMIC_RELAXED))
+    return 0;
+
+  mutex_lock(&deque->lock);
+  if (deque->bottom != deque->top)
+    task = deque->tasks[deque->top++ % POOL_DEQUE_SIZE];
+  mutex_unlock(&deque->lock);
+  return task;
+}
+
+//=============================================================================
+// TASKS
+//=============================================================================
+
+static int current_deque(pool_t *pool) {
+  int64_t tid = sys_gettid();
+
+  for (int i = 0; i < pool->worker_count; i++)
+    if (pool->tids[i] == tid)
+      return i;
+  return pool->worker_count;
+}
+
+// Primero la propia, despues se roba empezando por la siguiente
+static task_t *find_task(pool_t *pool, int own) {
+  task_t *task = pop(&pool->deques[own]);
+
+  for (int i = 1; task == 0 && i <= pool->worker_count; i++)
+    task = steal(&pool->deques[(own + i) % (pool->worker_count + 1)]);
+  return task;
+}
+
+static void run(task_t *task) {
+  task->result = task->function(task->arg);
+  __atomic_store_n(&task->done, 1, __ATOMIC_RELEASE);
+  sys_futex_wake(&task->done, (uint64_t)-1);
+}
+
+static task_t *alloc_task(pool_t *pool) {
+  mutex_lock(&pool->free_lock);
+  task_t *task = pool->free_tasks;
+  if (task != 0)
+    pool->free_tasks = task->next_free;
+  mutex_unlock(&pool->free_lock);
+  return task;
+}
+
+static void free_task(pool_t *pool, task_t *task) {
+  mutex_lock(&pool->free_lock);
+  task->next_free = pool->free_tasks;
+  pool->free_tasks = task;
+  mutex_unlock(&pool->free_lock);
+}
+
+//=============================================================================
+// POOL MEMORY
+//=============================================================================
+
+static pool_t *alloc_pool(void) {
+  pool_t *pool = free_pools;
+
+  if (pool != 0) {
+    uint64_t padding = pool->padding;
+    free_pools = pool->next_free;
+    for (uint64_t *word = (uint64_t *)pool; word < (uint64_t *)(pool + 1); word++)
+      *word = 0;
+    pool->padding = padding;
+    return pool;
+  }
+
+  // El heap llega en cero: no hace falta inicializar los deques
+  uint64_t padding = (8 - (uint64_t)sys_sbrk(0) % 8) % 8;
+  uint8_t *memory = sys_sbrk(padding + sizeof(pool_t));
+  if (memory == (uint8_t *)-1)
+    return 0;
+
+  pool = (pool_t *)(memory + padding);
+  pool->padding = padding;
+  return pool;
+}
+
+// Al final del heap se devuelve al kernel (que libera sus paginas); si no, se guarda
+static void free_pool(pool_t *pool) {
+  if ((void *)(pool + 1) == sys_sbrk(0)) {
+    sys_sbrk(-(int64_t)(pool->padding + sizeof(pool_t)));
+    return;
+  }
+
+  pool->next_free = free_pools;
+  free_pools = pool;
+}
+
+//=============================================================================
+// WORKERS
+//=============================================================================
+
+/*
+ * El valor de work se lee antes de buscar: si llega una tarea mientras tanto
+ * cambia y futex_wait vuelve enseguida, asi que no se pierde el aviso.
+ */
+static int64_t worker_loop(void *arg) {
+  worker_t *worker = (worker_t *)arg;
+  pool_t *pool = worker->pool;
+
+  while (!__atomic_load_n(&pool->stop, __ATOMIC_ACQUIRE)) {
+    uint32_t work = __atomic_load_n(&pool->work, __ATOMIC_ACQUIRE);
+    task_t *task = find_task(pool, worker->index);
+
+    if (task != 0) {
+      run(task);
+    } else {
+      __atomic_add_fetch(&pool->sleeping, 1, __ATOMIC_SEQ_CST);
+      sys_futex_wait(&pool->work, work);
+      __atomic_sub_fetch(&pool->sleeping, 1, __ATOMIC_SEQ_CST);
+    }
+  }
+  return 0;
+}
+
+pool_t *pool_create(int worker_count) {
+  if (worker_count < 1 || worker_count > POOL_MAX_WORKERS)
+    return 0;
+
+  pool_t *pool = alloc_pool();
+  if (pool == 0)
+    return 0;
+
+  for (int i = POOL_MAX_TASKS - 1; i >= 0; i--) {
+    pool->tasks[i].next_free = pool->free_tasks;
+    pool->free_tasks = &pool->tasks[i];
+  }
+
+  for (int i = 0; i < worker_count; i++) {
+    pool->workers[i].pool = pool;
+    pool->workers[i].index = i;
+    pool->tids[i] = thread_create(worker_loop, &pool->workers[i]);
+    if (pool->tids[i] < 0) {
+      pool->worker_count = i;
+      pool_destroy(pool);
+      return 0;
+    }
+    pool->worker_count = i + 1;
+  }
+  return pool;
+}
+
+void pool_destroy(pool_t *pool) {
+  __atomic_store_n(&pool->stop, 1, __ATOMIC_RELEASE);
+  __atomic_add_fetch(&pool->work, 1, __ATOMIC_RELEASE);
+  sys_futex_wake(&pool->work, (uint64_t)-1);
+
+  for (int i = 0; i < pool->worker_count; i++)
+    thread_join(pool->tids[i], 0);
+  free_pool(pool);
+}
+
+task_t *pool_submit(pool_t *pool, task_function_t function, void *arg) {
+  task_t *task = alloc_task(pool);
+  if (task == 0)
+    return 0;
+
+  task->function = function;
+  task->arg = arg;
+  task->done = 0;
+
+  // Con el deque lleno se ejecuta aca: el resultado es el mismo, solo se pierde paralelismo
+  if (!push(&pool->deques[current_deque(pool)], task)) {
+    run(task);
+    return task;
+  }
+
+  __atomic_add_fetch(&pool->work, 1, __ATOMIC_RELEASE);
+  if (__atomic_load_n(&pool->sleeping, __ATOMIC_SEQ_CST) != 0)
+    sys_futex_wake(&pool->work, 1);
+  return task;
+}
+
+int64_t task_join(pool_t *pool, task_t *task) {
+  int own = current_deque(pool);
+
+  while (!__atomic_load_n(&task->done, __ATOMIC_ACQUIRE)) {
+    task_t *other = find_task(pool, own);
+    if (other != 0)
+      run(other);
+    else
+      sys_futex_wait(&task->done, 0);
+  }
+
+  int64_t result = task->result;
+  free_task(pool, task);
+  return result;
+}
+
+//=============================================================================
+// PARALLEL FOR
+//=============================================================================
+
+typedef struct {
+  range_function_t body;
+  void *arg;
+  uint64_t next;                        // proximo chunk libre
+  uint64_t end;
+  uint64_t grain;
+} range_t;
+
+static int64_t drain(void *arg) {
+  range_t *range = (range_t *)arg;
+  uint64_t begin;
+
+  while ((begin = __atomic_fetch_add(&range->next, range->grain, __ATOMIC_RELAXED)) < range->end) {
+    uint64_t end = begin + range->grain < range->end ? begin + range->grain : range->end;
+    range->body(begin, end, range->arg);
+  }
+  return 0;
+}
+
+/*
+ * Cada worker recibe una tarea que va tomando chunks de un contador comun
+ * hasta agotarlos; asi un chunk lento no deja a los demas esperando.
+ */
+void parallel_for(pool_t *pool, uint64_t begin, uint64_t end, uint64_t grain, range_function_t body, void *arg) {
+  if (begin >= end)
+    return;
+
+  uint64_t count = end - begin;
+  if (grain == 0)
+    grain = count / (4 * (uint64_t)pool->worker_count) > 0 ? count / (4 * (uint64_t)pool->worker_count) : 1;
+
+  range_t range = {body, arg, begin, end, grain};
+  uint64_t chunks = (count + grain - 1) / grain;
+  uint64_t helpers = chunks - 1 < (uint64_t)pool->worker_count ? chunks - 1 : (uint64_t)pool->worker_count;
+  task_t *tasks[POOL_MAX_WORKERS];
+
+  for (uint64_t i = 0; i < helpers; i++)
+    tasks[i] = pool_submit(pool, drain, &range);
+  drain(&range);
+  for (uint64_t i = 0; i < helpers; i++)
+    if (tasks[i] != 0)
+      task_join(pool, tasks[i]);
+}
@@ -0,0 +1,66 @@
+#ifndef TASK_POOL_H
+#define TASK_POOL_H
+
+#include <stdint.h>
+
+#define POOL_MAX_WORKERS 16             // MAX_THREADS del kernel
+#define POOL_DEQUE_SIZE 256             // tareas encoladas por worker
+#define POOL_MAX_TASKS 1024             // tareas sin join a la vez
+
+typedef struct pool pool_t;
+typedef struct task task_t;             // una tarea es tambien su future
+
+typedef int64_t (*task_function_t)(void *arg);
+typedef void (*range_function_t)(uint64_t begin, uint64_t end, void *arg);
+
+/**
+ * Creates a pool of worker threads. Each worker has its own task deque:
+ * it takes work from the bottom and, when empty, steals from the top of
+ * the others. Idle workers sleep on a futex.
+ * @param workers Number of worker threads (1 to POOL_MAX_WORKERS)
+ * @return The new pool, or 0 on error
+ */
+pool_t *pool_create(int workers);
+
+/**
+ * Stops and joins the workers and releases the pool. Every submitted task
+ * must have been joined. Its memory goes back to the kernel if the pool is
+ * at the end of the heap, and is kept for the next pool_create otherwise.
+ * @param pool Pool to stop
+ */
+void pool_destroy(pool_t *pool);
+
+/**
+ * Queues function(arg) in the pool. Called from a worker, the task goes
+ * to that worker's own deque. If the deque is full the task runs right
+ * away in the caller.
+ * @param pool Pool
+ * @param function Task body
+ * @param arg Argument for function
+ * @return Future of the task, to pass to task_join, or 0 if
+ *         POOL_MAX_TASKS tasks are already waiting to be joined
+ */
+task_t *pool_submit(pool_t *pool, task_function_t function, void *arg);
+
+/**
+ * Waits for a task, running other queued tasks meanwhile, and releases it.
+ * @param pool Pool the task was submitted to
+ * @param task Future returned by pool_submit
+ * @return Value the task returned
+ */
+int64_t task_join(pool_t *pool, task_t *task);
+
+/**
+ * Calls body over consecutive chunks of [begin, end) in parallel and
+ * returns when every chunk is done. The caller works too. Chunks are
+ * handed out one at a time, so uneven chunks still balance.
+ * @param pool Pool
+ * @param begin First index
+ * @param end One past the last index
+ * @param grain Indices per chunk, or 0 to pick one from the pool size
+ * @param body Called as body(chunk_begin, chunk_end, arg)
+ * @param arg Argument for body
+ */
+void parallel_for(pool_t *pool, uint64_t begin, uint64_t end, uint64_t grain, range_function_t body, void *arg);
+
+#endif
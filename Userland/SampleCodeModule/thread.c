@@ -0,0 +1,16 @@
+#include <stdint.h>
+#include "syscalls.h"
+#include "thread.h"
+
+// El kernel arranca el thread aca con la funcion y su argumento en rdi/rsi
+static void thread_start(thread_function_t function, void *arg) {
+  sys_exit(function(arg));
+}
+
+int64_t thread_create(thread_function_t function, void *arg) {
+  return sys_thread_create((void *)thread_start, (uint64_t)function, (uint64_t)arg);
+}
+
+int64_t thread_join(int64_t tid, int64_t *result) {
+  return sys_thread_join(tid, result);
+}
@@ -0,0 +1,25 @@
+#ifndef THREAD_H
+#define THREAD_H
+
+#include <stdint.h>
+
+typedef int64_t (*thread_function_t)(void *arg);
+
+/**
+ * Starts a thread that runs function(arg) in this process, on its own
+ * stack. Returning from function ends the thread with that exit code.
+ * @param function Thread body
+ * @param arg Argument for function
+ * @return Thread id, or -1 on error
+ */
+int64_t thread_create(thread_function_t function, void *arg);
+
+/**
+ * Waits for a thread to finish.
+ * @param tid Thread id
+ * @param result Where to store the value function returned (may be 0)
+ * @return 0 on success, -1 if there is no such thread
+ */
+int64_t thread_join(int64_t tid, int64_t *result);
+
+#endif
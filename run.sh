@@ -1,2 +1,2 @@
 #!/bin/bash
-qemu-system-x86_64 -hda Image/x64BareBonesImage.qcow2 -m 512 
+qemu-system-x86_64 -drive file=Image/x64BareBonesImage.img,format=raw -m 512 